@@ -0,0 +1,168 @@
+#pragma once
+#include "journal_file.hpp"
+#include "spsc_ring.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum class JournalSync
+{
+    None,       // leave flushing to the OS
+    EveryWrite, // fdatasync after every batch written
+    Periodic,   // fdatasync at most once per syncInterval
+};
+
+struct JournalOptions
+{
+    std::size_t ringCapacity{std::size_t{1} << 16};  // entries in flight, rounded up to a power of two
+    std::size_t batchRecords{8192};                  // records per write() at most
+    JournalSync sync{JournalSync::None};
+    std::chrono::milliseconds syncInterval{10};
+    std::chrono::microseconds idleSleep{100};       // see IdleBackoff
+};
+
+// Waiting policy for the journal's polling loops: the first kSpins empty polls
+// yield, so a burst right after a short lull is picked up at once, and later
+// ones sleep, so an idle journal does not hold a core. reset() after progress.
+class IdleBackoff
+{
+    private:
+    std::chrono::microseconds m_sleep;
+    std::uint32_t m_idle{};
+
+    public:
+    static constexpr std::uint32_t kSpins = 64;
+
+    explicit IdleBackoff(std::chrono::microseconds sleep)
+    : m_sleep{sleep}
+    {}
+
+    void pause()
+    {
+        if (m_idle < kSpins)
+        {
+            ++m_idle;
+            std::this_thread::yield();
+        }
+        else std::this_thread::sleep_for(m_sleep);
+    }
+
+    void reset() { m_idle = 0; }
+};
+
+// Persists entries off the producing thread. append() is one SPSC ring push;
+// a writer thread drains the ring, encodes each entry with Codec and hands the
+// records to a JournalFile in large sequential writes. Codec supplies
+//   using Entry, using Record        what append() takes, what the file holds
+//   static constexpr JournalHeader kHeader
+//   Record encode(const Entry&, std::uint64_t sequence) const
+// where sequence numbers records from 0 across every run appending to the
+// file. Definitions are in async_journal_impl.hpp; each codec's source file
+// instantiates its journal.
+template<class Codec>
+class AsyncJournal
+{
+    public:
+    using Entry = typename Codec::Entry;
+    using Record = typename Codec::Record;
+
+    private:
+    SpscRing<Entry> m_ring;
+    Codec m_codec;
+    JournalOptions m_options;
+    JournalFile m_file;
+    std::uint64_t m_appended{};   // producer only
+    std::uint64_t m_stalls{};     // producer only
+    alignas(kCacheLine) std::atomic<std::uint64_t> m_written{0};
+    std::atomic<std::uint64_t> m_buffered{0};
+    std::atomic<std::uint64_t> m_syncs{0};
+    std::atomic<bool> m_failed{false};
+    std::atomic<bool> m_running{true};
+    std::chrono::steady_clock::time_point m_lastSync{}; // writer only
+    bool m_unsynced{false};                             // writer only: written since the last sync
+    std::thread m_writer;
+
+    void run();
+
+    void writeOut(std::vector<Record>& buffer);
+
+    void sync(std::chrono::steady_clock::time_point now);
+
+    public:
+    // Opens or creates the journal at path; throws std::system_error when the
+    // file cannot be opened or holds a different kind of journal.
+    AsyncJournal(const std::string& path, Codec codec, JournalOptions options = {});
+
+    // Writes everything appended so far, then syncs unless sync is None.
+    ~AsyncJournal();
+
+    AsyncJournal(const AsyncJournal&) = delete;
+    AsyncJournal& operator=(const AsyncJournal&) = delete;
+
+    // Producer only. Waits while the ring is full, so no entry is ever dropped;
+    // each time that happens stalls() goes up.
+    void append(const Entry& entry)
+    {
+        if (!m_ring.tryPush(entry)) [[unlikely]]
+        {
+            ++m_stalls;
+            IdleBackoff backoff{m_options.idleSleep};
+            while (!m_ring.tryPush(entry)) backoff.pause();
+        }
+        ++m_appended;
+    }
+
+    // Producer only. Blocks until every entry appended so far has been written.
+    void flush();
+
+    // Entries appended but not yet handed to the OS; callable from any thread.
+    std::uint64_t backlog() const
+    {
+        return m_ring.size() + m_buffered.load(std::memory_order_acquire);
+    }
+
+    // Written by this journal object, not counting records already in the file.
+    std::uint64_t written() const { return m_written.load(std::memory_order_acquire); }
+
+    // Records in the file when it was opened; the next entry's sequence is
+    // existing() plus everything appended since.
+    std::uint64_t existing() const { return m_file.records(); }
+
+    // Producer only. The sequence the next appended entry will get.
+    std::uint64_t nextSequence() const { return existing() + m_appended; }
+
+    std::uint64_t syncs() const { return m_syncs.load(std::memory_order_acquire); }
+
+    std::uint64_t stalls() const { return m_stalls; }
+
+    // A write failed; the writer stops writing and append() keeps draining.
+    bool failed() const { return m_failed.load(std::memory_order_acquire); }
+};
+
+// Sequential reader for a journal written by AsyncJournal<Codec>.
+template<class Codec>
+class BasicJournalReader
+{
+    public:
+    using Record = typename Codec::Record;
+
+    private:
+    std::ifstream m_in;
+    bool m_valid{false};
+
+    public:
+    explicit BasicJournalReader(const std::string& path);
+
+    // False when the file is missing or its header is not Codec's.
+    bool valid() const { return m_valid; }
+
+    // Reads up to out.size() records and returns how many; 0 at the end. A
+    // trailing partial record, left by a crash mid-write, is not returned.
+    std::size_t read(std::span<Record> out);
+};
@@ -0,0 +1,113 @@
+#pragma once
+// Member definitions of AsyncJournal and BasicJournalReader, for the source
+// file that instantiates them for a codec.
+#include "async_journal.hpp"
+#include <array>
+
+    template<class Codec>
+    AsyncJournal<Codec>::AsyncJournal(const std::string& path, Codec codec, JournalOptions options)
+    : m_ring{options.ringCapacity}
+    , m_codec{std::move(codec)}
+    , m_options{options}
+    , m_file{path, Codec::kHeader}
+    {
+        m_writer = std::thread([this]{ run(); });
+    }
+
+    template<class Codec>
+    AsyncJournal<Codec>::~AsyncJournal()
+    {
+        m_running.store(false, std::memory_order_release);
+        m_writer.join();
+        if (m_options.sync != JournalSync::None && !failed()) m_file.sync();
+    }
+
+    template<class Codec>
+    void AsyncJournal<Codec>::flush()
+    {
+        IdleBackoff backoff{m_options.idleSleep};
+        while (written() < m_appended && !failed()) backoff.pause();
+    }
+
+    // Gathers records until a batch is full or the ring runs dry, then writes
+    // them in one call. When idle it backs off from yielding to sleeping, so a
+    // burst is picked up at once but a quiet journal costs no core, and under
+    // Periodic it syncs the tail of the last burst once the interval is up
+    // rather than waiting for another write.
+    template<class Codec>
+    void AsyncJournal<Codec>::run()
+    {
+        constexpr std::size_t kPopBatch = 256;
+        std::array<Entry, kPopBatch> popped;
+        std::vector<Record> buffer;
+        buffer.reserve(m_options.batchRecords + kPopBatch);
+        std::uint64_t sequence = m_file.records();
+        IdleBackoff backoff{m_options.idleSleep};
+        while (true)
+        {
+            const std::size_t count = m_ring.popBatch(popped.data(), popped.size());
+            if (count > 0)
+            {
+                backoff.reset();
+                m_buffered.fetch_add(count, std::memory_order_release);
+                for (std::size_t i = 0; i < count; ++i) buffer.push_back(m_codec.encode(popped[i], sequence++));
+                if (buffer.size() >= m_options.batchRecords) writeOut(buffer);
+                continue;
+            }
+            if (!buffer.empty())
+            {
+                writeOut(buffer);
+                continue;
+            }
+            if (!m_running.load(std::memory_order_acquire) && m_ring.size() == 0) return;
+            if (m_unsynced && m_options.sync == JournalSync::Periodic)
+            {
+                const auto now = std::chrono::steady_clock::now();
+                if (now - m_lastSync >= m_options.syncInterval) sync(now);
+            }
+            backoff.pause();
+        }
+    }
+
+    template<class Codec>
+    void AsyncJournal<Codec>::writeOut(std::vector<Record>& buffer)
+    {
+        const std::size_t count = buffer.size();
+        const bool ok = !failed() && m_file.append(buffer.data(), count * sizeof(Record));
+        if (!ok) m_failed.store(true, std::memory_order_release);
+        buffer.clear();
+        if (ok && m_options.sync != JournalSync::None)
+        {
+            m_unsynced = true;
+            const auto now = std::chrono::steady_clock::now();
+            if (m_options.sync == JournalSync::EveryWrite || now - m_lastSync >= m_options.syncInterval) sync(now);
+        }
+        m_buffered.fetch_sub(count, std::memory_order_release);
+        if (ok) m_written.fetch_add(count, std::memory_order_release);
+    }
+
+    template<class Codec>
+    void AsyncJournal<Codec>::sync(std::chrono::steady_clock::time_point now)
+    {
+        m_file.sync();
+        m_lastSync = now;
+        m_unsynced = false;
+        m_syncs.fetch_add(1, std::memory_order_release);
+    }
+
+    template<class Codec>
+    BasicJournalReader<Codec>::BasicJournalReader(const std::string& path)
+    : m_in{path, std::ios::binary}
+    {
+        JournalHeader found{};
+        m_in.read(reinterpret_cast<char*>(&found), sizeof(found));
+        m_valid = m_in.gcount() == static_cast<std::streamsize>(sizeof(found)) && found == Codec::kHeader;
+    }
+
+    template<class Codec>
+    std::size_t BasicJournalReader<Codec>::read(std::span<Record> out)
+    {
+        if (!m_valid || out.empty()) return 0;
+        m_in.read(reinterpret_cast<char*>(out.data()), static_cast<std::streamsize>(out.size_bytes()));
+        return static_cast<std::size_t>(m_in.gcount()) / sizeof(Record);
+    }
@@ -0,0 +1,144 @@
+#pragma once
+#include "fenwick_tree.hpp"
+#include "level_bitmap.hpp"
+#include "order.hpp"
+#include "order_pool.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory_resource>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+struct PriceLevel 
+{
+  OrderQueue orders;
+  Quantity levelQTY{};
+};
+
+// Inclusive range of prices a ladder book accepts.
+struct PriceBand
+{
+    Price minPrice{};
+    Price maxPrice{};
+};
+
+// A band a ladder can be built over: positive, with minPrice <= maxPrice.
+inline bool validBand(PriceBand band) { return band.minPrice > 0 && band.maxPrice >= band.minPrice; }
+
+// The price levels of one side of a book, best first under Compare. A
+// default-constructed side keeps levels in a std::map and accepts any price. A
+// side built from a PriceBand is a dense ladder instead: one PriceLevel per tick
+// in the band, indexed by price - minPrice, with the best index cached so level
+// insertion, removal and best-price lookups are array writes rather than tree
+// operations. On a ladder a level exists exactly when its queue is non-empty, and
+// an occupancy bitmap finds the next level when the best one empties. A ladder
+// also keeps a Fenwick tree of levelQTY by tick, so the depth available at or
+// better than any price is a prefix sum rather than a walk over levels. Every
+// change to a level's quantity therefore goes through addQuantity or
+// removeQuantity, and erasing a level retires whatever levelQTY it still holds.
+template<typename Compare>
+class BookSide
+{
+    private:
+    static constexpr std::size_t kNoLevel = LevelBitmap::npos;
+    // Bids (std::greater) improve towards higher ladder indices, asks towards lower.
+    static constexpr bool kBetterIsHigher = std::is_same_v<Compare, std::greater<Price>>;
+
+    std::pmr::map<Price, PriceLevel, Compare> m_levels;
+    std::pmr::vector<PriceLevel> m_ladder;
+    LevelBitmap m_occupied;
+    FenwickTree m_depth;
+    Price m_minPrice{};
+    std::size_t m_best{kNoLevel};
+    std::size_t m_ladderLevels{};
+    bool m_isLadder{false};
+
+    std::size_t indexOf(Price price) const { return static_cast<std::size_t>(price - m_minPrice); }
+    Price priceAt(std::size_t index) const { return m_minPrice + static_cast<Price>(index); }
+    std::size_t nextWorse(std::size_t from) const
+    {
+        if constexpr (kBetterIsHigher) return from == 0 ? kNoLevel : m_occupied.prevSet(from - 1);
+        else return m_occupied.nextSet(from + 1);
+    }
+
+    public:
+    // Map nodes, or the ladder and its bitmap and depth tree, come from resource.
+    explicit BookSide(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    // Throws std::invalid_argument unless validBand(band).
+    explicit BookSide(PriceBand band, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    // True when price is at limit or better for this side.
+    static constexpr bool noWorseThan(Price price, Price limit) { return !Compare{}(limit, price); }
+
+    bool isLadder() const { return m_isLadder; }
+
+    bool empty() const { return m_isLadder ? m_best == kNoLevel : m_levels.empty(); }
+
+    std::size_t levelCount() const { return m_isLadder ? m_ladderLevels : m_levels.size(); }
+
+    bool inBand(Price price) const;
+
+    // A ladder's band; meaningless for a std::map side.
+    PriceBand band() const { return PriceBand{m_minPrice, priceAt(m_ladder.size() - 1)}; }
+
+    // Precondition for bestPrice/bestLevel/eraseBest: !empty().
+    Price bestPrice() const { return m_isLadder ? priceAt(m_best) : m_levels.begin()->first; }
+
+    PriceLevel& bestLevel() { return m_isLadder ? m_ladder[m_best] : m_levels.begin()->second; }
+
+    // Level at price, created if absent. The caller must rest an order in it.
+    PriceLevel& levelFor(Price price);
+
+    PriceLevel* find(Price price);
+
+    void addQuantity(PriceLevel& level, Price price, Quantity quantity);
+
+    void removeQuantity(PriceLevel& level, Price price, Quantity quantity);
+
+    // True when levels priced at limit or better hold at least volume in total.
+    bool hasDepth(Price limit, Quantity volume) const;
+
+    // Drops a level whose queue has just emptied.
+    void erase(Price price);
+
+    void eraseBest();
+
+    // Brings back a level from a snapshot: its queue, already linked in the
+    // pool, and its total quantity. The level must not exist yet.
+    void restoreLevel(Price price, OrderQueue orders, Quantity levelQTY);
+
+    // Copies the best levels' prices and total quantities into the parallel
+    // arrays, up to the shorter of the two; returns how many were written.
+    // Reads levelQTY only, never an order queue.
+    std::size_t topLevels(std::span<Price> prices, std::span<Quantity> quantities) const;
+
+    // Drops every level. A ladder keeps its arrays and only visits occupied
+    // ticks; a std::map side releases its nodes to the resource.
+    void clear();
+
+    // Calls visit(price, level) on each level from best to worst until it
+    // returns false.
+    template<typename Visitor>
+    void forEachLevel(Visitor&& visit) const
+    {
+        if (!m_isLadder)
+        {
+            for (const auto& [price, level] : m_levels)
+            {
+                if (!visit(price, level)) return;
+            }
+            return;
+        }
+        for (std::size_t i = m_best; i != kNoLevel; i = nextWorse(i))
+        {
+            if (!visit(priceAt(i), m_ladder[i])) return;
+        }
+    }
+};
+
+extern template class BookSide<std::greater<Price>>;
+extern template class BookSide<std::less<Price>>;
@@ -0,0 +1,91 @@
+#pragma once
+#include "order.hpp"
+#include "trade.hpp"
+#include <cstddef>
+#include <cstdint>
+
+using SymbolID = size_t; 
+
+// One engine instruction as a fixed-size record, so it can be queued, batched
+// or logged without any per-command allocation. Fields a command type does not
+// use are left zero.
+struct Command
+{
+    enum class Type
+    {
+        Limit,
+        Market,
+        Cancel,
+        Reduce,
+        CancelReplace,
+    };
+
+    Type type{};
+    OrderSide side{};
+    LimitType limitType{};
+    SymbolID ticker{};
+    OrderID id{};
+    Price price{};
+    Quantity qty{};
+    OrderID newID{};    // cancel-replace only: the replacement's ID, 0 to let the engine pick
+
+    static Command limit(SymbolID ticker, OrderSide side, Quantity qty, OrderID id, Price price, LimitType type = LimitType::GTC)
+    {
+        return Command{Type::Limit, side, type, ticker, id, price, qty};
+    }
+
+    static Command market(SymbolID ticker, OrderSide side, Quantity qty, OrderID id)
+    {
+        return Command{Type::Market, side, LimitType::GTC, ticker, id, 0, qty};
+    }
+
+    static Command cancel(OrderID id, SymbolID ticker = 0)
+    {
+        return Command{Type::Cancel, OrderSide::Bid, LimitType::GTC, ticker, id, 0, 0};
+    }
+
+    static Command reduce(OrderID id, Quantity newQty, SymbolID ticker = 0)
+    {
+        return Command{Type::Reduce, OrderSide::Bid, LimitType::GTC, ticker, id, 0, newQty};
+    }
+
+    static Command cancelReplace(OrderID id, Quantity newQty, Price newPrice, SymbolID ticker = 0, OrderID newID = 0)
+    {
+        return Command{Type::CancelReplace, OrderSide::Bid, LimitType::GTC, ticker, id, newPrice, newQty, newID};
+    }
+};
+
+enum class CommandStatus
+{
+    Accepted,
+    Rejected, // failed validation (zero quantity, bad price, invalid reduce)
+    NotFound, // modify of an order that is not resting
+    ResidualRefused, // traded filledQTY, but the GTC residual had no room to rest
+};
+
+// Outcome of one command in a batch. Its fills are
+// fills[firstFill, firstFill + fillCount) of the batch's fill buffer.
+struct CommandResult
+{
+    CommandStatus status{CommandStatus::Accepted};
+    Quantity filledQTY{};
+    Quantity restedQTY{};
+    std::uint32_t firstFill{};
+    std::uint32_t fillCount{};
+};
+
+struct Fill
+{
+    TradeID tradeID{};
+    OrderID aggressorID{};
+    OrderID restingID{};
+    Price price{};
+    Quantity qty{};
+};
+
+struct BatchSummary
+{
+    std::size_t commands{};
+    std::size_t fills{};
+    std::size_t fillsDropped{}; // fills that did not fit the buffer (still in the trade log)
+};
@@ -0,0 +1,60 @@
+#pragma once
+#include "async_journal.hpp"
+#include "command.hpp"
+#include <cstdint>
+
+// Command log file format, version 1:
+//
+//   header, 16 bytes:  char magic[8] = "OBCMDLOG"
+//                      u32  version  = 1
+//                      u32  recordSize = sizeof(CommandRecord) = 32
+//   records, back to back, one per accepted command in the order the engine
+//   applied them, numbered by sequence from 0.
+struct CommandRecord
+{
+    std::uint64_t sequence{};
+    std::uint8_t type{};        // Command::Type
+    std::uint8_t side{};        // OrderSide
+    std::uint8_t limitType{};   // LimitType
+    std::uint8_t reserved{};
+    std::uint32_t ticker{};
+    OrderID id{};
+    Price price{};
+    Quantity qty{};
+    OrderID newID{};            // cancel-replace: the ID the replacement got
+};
+
+static_assert(sizeof(CommandRecord) == 32);
+
+struct CommandCodec
+{
+    using Entry = Command;
+    using Record = CommandRecord;
+
+    static constexpr JournalHeader kHeader{{'O', 'B', 'C', 'M', 'D', 'L', 'O', 'G'}, 1, sizeof(CommandRecord)};
+
+    CommandRecord encode(const Command& command, std::uint64_t sequence) const;
+
+    static Command decode(const CommandRecord& record);
+};
+
+// Write-ahead log of the commands an engine accepted. Attach one with
+// engine.commandLog = &log; the engine appends each command once it has passed
+// validation and before it touches a book, and a cancel-replace is logged with
+// the ID its replacement received, so replaying the log reproduces the books
+// exactly. Writes are batched by a writer thread: with JournalSync::EveryWrite
+// a crash loses at most what backlog() reported.
+using CommandLog = AsyncJournal<CommandCodec>;
+
+using CommandLogReader = BasicJournalReader<CommandCodec>;
+
+// What BasicMatchingEngine::replay recovered.
+struct ReplaySummary
+{
+    std::uint64_t commands{};       // applied
+    std::uint64_t nextSequence{};   // sequence the next logged command should get
+    bool gap{false};                // stopped at a record out of sequence
+};
+
+extern template class AsyncJournal<CommandCodec>;
+extern template class BasicJournalReader<CommandCodec>;
@@ -0,0 +1,67 @@
+#pragma once
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <emmintrin.h>
+#include <x86intrin.h>
+
+
+static inline uint64_t startClock(){
+  _mm_lfence();
+  return __rdtsc();
+}
+
+
+static inline uint64_t stopClock(){
+
+  unsigned aux;
+  auto end = __rdtscp(&aux);
+  _mm_lfence();
+  return end;
+}
+
+// Plain counter read with no fencing, for timestamps rather than intervals.
+static inline uint64_t readCounter(){
+  return __rdtsc();
+}
+
+#elif defined(__aarch64__)
+
+// No rdtsc on ARM; cntvct_el0 is the constant-rate generic timer and isb
+// serializes the pipeline the way lfence does on x86.
+static inline uint64_t startClock(){
+  uint64_t ticks;
+  __asm__ __volatile__("isb\n\tmrs %0, cntvct_el0" : "=r"(ticks) :: "memory");
+  return ticks;
+}
+
+
+static inline uint64_t stopClock(){
+  uint64_t ticks;
+  __asm__ __volatile__("isb\n\tmrs %0, cntvct_el0" : "=r"(ticks) :: "memory");
+  return ticks;
+}
+
+static inline uint64_t readCounter(){
+  uint64_t ticks;
+  __asm__ __volatile__("mrs %0, cntvct_el0" : "=r"(ticks));
+  return ticks;
+}
+
+#else
+#error "cycle_counter.hpp: unsupported architecture"
+#endif
+
+
+// Counter ticks per nanosecond. cntfrq_el0 reports the rate directly on ARM;
+// the TSC rate is not architecturally exposed on x86, so the first call
+// measures it against steady_clock, sleeping rather than spinning for about
+// 50 ms. Call calibrateCounter() at startup so that never happens on a hot
+// thread; TradeClock and PublishedDepth do it when they are built.
+double ticksPerNs();
+
+// Measures the rate now if it has not been measured yet.
+inline void calibrateCounter()
+{
+    static_cast<void>(ticksPerNs());
+}
@@ -0,0 +1,101 @@
+#pragma once
+#include "book_side.hpp"
+#include "order.hpp"
+#include <cstddef>
+#include <memory_resource>
+#include <span>
+#include <vector>
+
+// One aggregated (L2) price-level change: the level's total resting quantity
+// once the command finished, 0 when the level is gone or, in a top-N view, has
+// dropped out of the window.
+struct DepthUpdate
+{
+    OrderSide side{};
+    Price price{};
+    Quantity qty{};
+};
+
+// Turns one book's level changes into a stream of DepthUpdates, coalesced per
+// command. The book calls touch() wherever a level's quantity changes; collect()
+// at the end of the command returns one update per level that changed.
+//
+// The view is either full depth or the best `depth` levels per side. Full
+// depth remembers each touched price and reads the level's final quantity at
+// collect(). A top-N view remembers the window it last published and only
+// notes that a side needs diffing, and only when the touched price is inside
+// that window, so activity further down the book costs one comparison. A
+// level that enters the window because a better one left is published too.
+//
+// Disabled until enable(); then touch() is one predictable branch.
+class DepthTracker
+{
+    private:
+    std::pmr::vector<DepthUpdate> m_touched;    // full depth: every touch this command
+    std::pmr::vector<DepthUpdate> m_window[2];  // top-N: last published, best first
+    std::pmr::vector<DepthUpdate> m_scratch;
+    std::pmr::vector<DepthUpdate> m_out;
+    std::size_t m_depth{};
+    bool m_enabled{false};
+    bool m_dirty[2]{};
+
+    static constexpr std::size_t indexOf(OrderSide side) { return side == OrderSide::Bid ? 0 : 1; }
+
+    template<OrderSide S>
+    bool inWindow(Price price) const
+    {
+        const auto& window = m_window[indexOf(S)];
+        if (window.size() < m_depth) return true;
+        if constexpr (S == OrderSide::Bid) return price >= window.back().price;
+        else return price <= window.back().price;
+    }
+
+    template<OrderSide S, class Side>
+    void diffWindow(Side& side);
+
+    public:
+    explicit DepthTracker(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+    : m_touched(resource)
+    , m_window{std::pmr::vector<DepthUpdate>(resource), std::pmr::vector<DepthUpdate>(resource)}
+    , m_scratch(resource)
+    , m_out(resource)
+    {}
+
+    // Starts tracking: depth levels per side, 0 for every level. In a top-N
+    // view the first collect() publishes the whole current window.
+    void enable(std::size_t depth);
+
+    void disable();
+
+    bool enabled() const { return m_enabled; }
+
+    // Levels per side in the view; 0 means full depth.
+    std::size_t depth() const { return m_depth; }
+
+    template<OrderSide S>
+    void touch(Price price)
+    {
+        if (!m_enabled) [[likely]] return;
+        if (m_depth == 0) m_touched.push_back(DepthUpdate{S, price, 0});
+        else if (!m_dirty[indexOf(S)] && inWindow<S>(price)) m_dirty[indexOf(S)] = true;
+    }
+
+    // The updates since the last collect(), bids then asks, each best first.
+    // Valid until the next call.
+    template<class Bids, class Asks>
+    std::span<const DepthUpdate> collect(Bids& bids, Asks& asks);
+
+    // Touches every level the book has now. Called before the book is emptied,
+    // the next collect() reports each level a consumer holds as 0 unless it is
+    // back by then; called after levels are restored wholesale, it publishes
+    // them. A top-N view just marks both sides for diffing.
+    template<class Bids, class Asks>
+    void touchAll(const Bids& bids, const Asks& asks);
+
+    // Forgets every pending touch and published window without publishing;
+    // a top-N view republishes its window at the next collect().
+    void clear();
+};
+
+extern template std::span<const DepthUpdate> DepthTracker::collect(BookSide<std::greater<Price>>&, BookSide<std::less<Price>>&);
+extern template void DepthTracker::touchAll(const BookSide<std::greater<Price>>&, const BookSide<std::less<Price>>&);
@@ -0,0 +1,116 @@
+#pragma once
+#include "book_side.hpp"
+#include "order.hpp"
+#include "spsc_ring.hpp"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <span>
+#include <vector>
+
+// How often the matching thread refreshes a book's published depth: after
+// every `commands` commands on the book, or once `interval` has passed since
+// the last refresh, checked at the end of each command. Zero turns a trigger
+// off.
+struct DepthViewCadence
+{
+    std::uint32_t commands{};
+    std::chrono::microseconds interval{};
+};
+
+class PublishedDepth;
+
+// A reader's hold on one published depth image: every level of both sides,
+// best first, as parallel price and quantity arrays. The image does not change
+// while the view is alive, and the writer will not reuse its buffer until the
+// view is destroyed, so hold it only as long as the analysis needs it. Only
+// views from PublishedDepth::acquire() can be read; a default one holds nothing.
+class DepthView
+{
+    private:
+    friend class PublishedDepth;
+
+    struct Buffer;
+    const Buffer* m_buffer{nullptr};
+
+    explicit DepthView(const Buffer* buffer)
+    : m_buffer{buffer}
+    {}
+
+    public:
+    DepthView() = default;
+
+    DepthView(DepthView&& other) noexcept;
+    DepthView& operator=(DepthView&& other) noexcept;
+
+    DepthView(const DepthView&) = delete;
+    DepthView& operator=(const DepthView&) = delete;
+
+    ~DepthView();
+
+    // Refreshes published before this image, 0 for the empty one shown
+    // before the first.
+    std::uint64_t epoch() const;
+
+    std::span<const Price> bidPrices() const;
+    std::span<const Quantity> bidQuantities() const;
+    std::span<const Price> askPrices() const;
+    std::span<const Quantity> askQuantities() const;
+};
+
+// RCU-style double buffer holding one book's full depth for reader threads.
+// The matching thread writes the buffer readers are not pointed at, then
+// swings the current index to it; readers pin the current buffer with a
+// reader count and never see the live book. If a slow reader still pins the
+// buffer due for reuse, the refresh is skipped and retried at the next
+// command whatever the cadence, so the writer never waits. Readers retry only when a swap lands
+// between their load of the index and their pin.
+class PublishedDepth
+{
+    private:
+    std::array<DepthView::Buffer*, 2> m_buffers{};
+    std::pmr::memory_resource* m_resource;
+    alignas(kCacheLine) std::atomic<std::uint32_t> m_current{0};
+    std::atomic<std::uint64_t> m_epoch{0};
+    std::atomic<std::uint64_t> m_skipped{0};
+    // Writer only.
+    alignas(kCacheLine) DepthViewCadence m_cadence;
+    std::uint64_t m_intervalTicks{};
+    std::uint64_t m_lastRefresh{};
+    std::uint32_t m_sinceRefresh{};
+    bool m_retry{};   // the last refresh was skipped
+
+    public:
+    // levelHint presizes each buffer's arrays; a ladder book passes its band
+    // width so refreshing never allocates.
+    PublishedDepth(DepthViewCadence cadence, std::size_t levelHint, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    ~PublishedDepth();
+
+    PublishedDepth(const PublishedDepth&) = delete;
+    PublishedDepth& operator=(const PublishedDepth&) = delete;
+
+    // Writer only. Counts a command and says whether the cadence calls for a
+    // refresh; reads the cycle counter only when an interval is set.
+    bool due();
+
+    // Writer only. Copies both sides into the idle buffer and publishes it
+    // under the next epoch. Returns false, publishing nothing, when a reader
+    // still holds the idle buffer.
+    template<class Bids, class Asks>
+    bool refresh(const Bids& bids, const Asks& asks);
+
+    // Any thread.
+    DepthView acquire() const;
+
+    // Any thread. Refreshes published so far, and refreshes skipped because a
+    // reader held the buffer.
+    std::uint64_t epoch() const { return m_epoch.load(std::memory_order_acquire); }
+
+    std::uint64_t skipped() const { return m_skipped.load(std::memory_order_relaxed); }
+};
+
+extern template bool PublishedDepth::refresh(const BookSide<std::greater<Price>>&, const BookSide<std::less<Price>>&);
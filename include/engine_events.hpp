@@ -0,0 +1,116 @@
+#pragma once
+#include "command.hpp"
+#include "depth_tracker.hpp"
+#include "order.hpp"
+#include "trade.hpp"
+#include "trade_journal.hpp"
+#include <concepts>
+#include <cstddef>
+#include <memory_resource>
+#include <type_traits>
+
+enum class RejectReason
+{
+    InvalidQuantity, // zero quantity, or a reduce that would not shrink the order
+    InvalidPrice,    // non-positive, or outside the book's ladder band
+    CapacityLimit,   // a fixed-capacity engine has no slot left for the order
+    UnknownOrder,    // cancel, reduce or cancel-replace of an order not resting;
+                     // the engine cannot tell its symbol and reports 0
+    InvalidOrderID,  // the ID the order index reserves for empty slots
+    DuplicateOrderID, // a new order reusing the ID of one still resting
+    UnknownSymbol,   // a ticker at or past the engine's symbol count
+};
+
+// An order entering or leaving a book. qty is what the event added to or took
+// off that price level: the rested quantity for onRest, the quantity removed
+// for onCancel, and the amount cut for onReduce (the order keeps resting with
+// the rest).
+struct OrderEvent
+{
+    SymbolID symbol{};
+    OrderID id{};
+    OrderSide side{};
+    Price price{};
+    Quantity qty{};
+};
+
+// What a BasicMatchingEngine reports as it matches. The engine calls the sink's
+// members directly, so with the sink type fixed at compile time every hook is
+// an ordinary inlinable call; an empty hook costs nothing.
+//   onTrade   one execution against a resting order
+//   onRest    the unfilled part of a GTC limit joined the book
+//   onCancel  a resting order was cancelled (also the old leg of a cancel-replace)
+//   onReduce  a resting order's quantity was cut in place
+//   onReject  a submission or modify was refused
+// A sink may also provide reset(), called by the engine's reset(), a
+// (std::size_t tradeCapacity, std::pmr::memory_resource*) constructor, which
+// the engine uses so stateful sinks allocate from its resource, and
+//   onDepth   one coalesced L2 level change, at the end of the command
+// for the books the engine has been asked to track (see DepthPublishing).
+template<class Sink>
+concept EventSink = requires(Sink& sink, const Trade& trade, const OrderEvent& order, SymbolID symbol, OrderID id, RejectReason reason)
+{
+    sink.onTrade(trade);
+    sink.onRest(order);
+    sink.onCancel(order);
+    sink.onReduce(order);
+    sink.onReject(symbol, id, reason);
+};
+
+template<class Sink>
+Sink makeSink(std::size_t tradeCapacity, std::pmr::memory_resource* resource)
+{
+    if constexpr (std::is_constructible_v<Sink, std::size_t, std::pmr::memory_resource*>) return Sink(tradeCapacity, resource);
+    else return Sink{};
+}
+
+// The default sink: trades go into a bounded TradeLog, and into a
+// TradeJournal when one is attached; everything else is dropped.
+struct TradeLogSink
+{
+    TradeLog tradelog;
+    TradeJournal* journal{nullptr};
+
+    TradeLogSink() = default;
+
+    TradeLogSink(std::size_t tradeCapacity, std::pmr::memory_resource* resource)
+    : tradelog(tradeCapacity, resource)
+    {}
+
+    void onTrade(const Trade& trade)
+    {
+        tradelog.record(trade);
+        if (journal != nullptr) journal->append(trade);
+    }
+
+    void onRest(const OrderEvent&) {}
+    void onCancel(const OrderEvent&) {}
+    void onReduce(const OrderEvent&) {}
+    void onReject(SymbolID, OrderID, RejectReason) {}
+
+    void reset() { tradelog.clear(); }
+};
+
+// Discards every event, for benchmarks that time matching alone.
+struct NullSink
+{
+    void onTrade(const Trade&) {}
+    void onRest(const OrderEvent&) {}
+    void onCancel(const OrderEvent&) {}
+    void onReduce(const OrderEvent&) {}
+    void onReject(SymbolID, OrderID, RejectReason) {}
+};
+
+// Sinks that take L2 depth updates.
+template<class Sink>
+concept DepthPublishing = requires(Sink& sink, SymbolID symbol, const DepthUpdate& update)
+{
+    sink.onDepth(symbol, update);
+};
+
+// Sinks that keep a trade log, for the engine's log queries.
+template<class Sink>
+concept TradeLogging = requires(const Sink& sink)
+{
+    { sink.tradelog } -> std::convertible_to<const TradeLog&>;
+};
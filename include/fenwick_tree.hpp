@@ -0,0 +1,30 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+// Fenwick (binary indexed) tree of quantities over ladder indices. Adding to
+// one index and summing a prefix are both O(log n) walks over a flat array,
+// so cumulative depth up to any tick is available without visiting levels.
+class FenwickTree
+{
+    private:
+    std::pmr::vector<std::uint64_t> m_tree; // 1-based: m_tree[0] is unused
+    std::uint64_t m_total{};
+
+    public:
+    FenwickTree() = default;
+
+    explicit FenwickTree(std::size_t size, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    void add(std::size_t index, std::uint64_t amount);
+
+    // amount must not exceed what was added at index.
+    void subtract(std::size_t index, std::uint64_t amount);
+
+    // Sum over indices [0, index].
+    std::uint64_t prefix(std::size_t index) const;
+
+    std::uint64_t total() const { return m_total; }
+};
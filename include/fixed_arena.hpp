@@ -0,0 +1,40 @@
+#pragma once
+#include <cstddef>
+#include <memory_resource>
+
+// One block of memory reserved up front for a fixed-capacity engine. On Linux
+// it is a single prefaulted mapping, backed by 2 MB huge pages when asked for
+// and available (MAP_HUGETLB, else a transparent huge page hint); elsewhere it
+// comes from operator new. Allocations are handed out by a monotonic resource
+// whose upstream is null_memory_resource, so running past the block throws
+// std::bad_alloc instead of quietly falling back to malloc.
+class FixedArena
+{
+    private:
+    struct Block
+    {
+        void* base{};
+        std::size_t bytes{};
+        bool hugePages{false};
+    };
+
+    Block m_block;
+    std::pmr::monotonic_buffer_resource m_resource;
+
+    static Block reserve(std::size_t bytes, bool hugePages);
+
+    public:
+    FixedArena(std::size_t bytes, bool hugePages);
+
+    ~FixedArena();
+
+    FixedArena(const FixedArena&) = delete;
+    FixedArena& operator=(const FixedArena&) = delete;
+
+    std::pmr::memory_resource* resource() { return &m_resource; }
+
+    std::size_t capacity() const { return m_block.bytes; }
+
+    // True only when the block is on explicit huge pages.
+    bool onHugePages() const { return m_block.hugePages; }
+};
@@ -0,0 +1,46 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// First 16 bytes of every journal file. All integers in journal files are in
+// host byte order (little-endian on every supported target).
+struct JournalHeader
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t recordSize;
+};
+
+static_assert(sizeof(JournalHeader) == 16);
+
+bool operator==(const JournalHeader& lhs, const JournalHeader& rhs);
+
+// An append-only file of fixed-size records behind a JournalHeader. Opening
+// an empty file writes the header; opening an existing one checks it and cuts
+// off a partial record left at the end by a crash, so appends stay aligned.
+class JournalFile
+{
+    private:
+    int m_fd{-1};
+    std::uint64_t m_records{};
+
+    public:
+    // Throws std::system_error when the file cannot be opened or its header
+    // differs from header.
+    JournalFile(const std::string& path, const JournalHeader& header);
+
+    ~JournalFile();
+
+    JournalFile(const JournalFile&) = delete;
+    JournalFile& operator=(const JournalFile&) = delete;
+
+    // Whole records already in the file when it was opened.
+    std::uint64_t records() const { return m_records; }
+
+    // Writes all of data, retrying short writes; false on an I/O error.
+    bool append(const void* data, std::size_t bytes);
+
+    // fdatasync where available, fsync elsewhere.
+    void sync();
+};
@@ -0,0 +1,47 @@
+#pragma once
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+// Occupancy bitmap over ladder indices, built as a hierarchy of 64-bit words:
+// bit i of tier 0 marks index i, and bit w of tier t+1 is set while word w of
+// tier t is non-zero. Finding the nearest occupied index in either direction
+// is one tzcnt/lzcnt per tier, so even a sparse band of a few hundred thousand
+// ticks resolves in three word reads instead of a linear scan.
+class LevelBitmap
+{
+    public:
+    static constexpr std::size_t npos = SIZE_MAX;
+
+    private:
+    std::pmr::vector<std::pmr::vector<std::uint64_t>> m_tiers;
+
+    static std::size_t highestBit(std::uint64_t bits)
+    {
+        return 63 - static_cast<std::size_t>(std::countl_zero(bits));
+    }
+
+    static std::size_t lowestBit(std::uint64_t bits)
+    {
+        return static_cast<std::size_t>(std::countr_zero(bits));
+    }
+
+    public:
+    LevelBitmap() = default;
+
+    explicit LevelBitmap(std::size_t size, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    void set(std::size_t index);
+
+    void clear(std::size_t index);
+
+    bool test(std::size_t index) const;
+
+    // Lowest set index >= from, or npos.
+    std::size_t nextSet(std::size_t from) const;
+
+    // Highest set index <= from, or npos.
+    std::size_t prevSet(std::size_t from) const;
+};
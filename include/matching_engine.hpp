@@ -1,40 +1,275 @@
 #pragma once
+#include "command.hpp"
+#include "command_log.hpp"
+#include "engine_events.hpp"
+#include "fixed_arena.hpp"
+#include "mpsc_ring.hpp"
 #include "order.hpp"
 #include "order_book.hpp"
+#include "order_index.hpp"
+#include "snapshot.hpp"
+#include "top_of_book.hpp"
 #include "trade.hpp"
+#include "trade_clock.hpp"
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <span>
 #include <unordered_map> 
 #include <string>
 
-using SymbolID = size_t; 
-struct MatchingEngine
+// Bounds for a fixed-capacity engine. Every book is a ladder over band, so the
+// price levels per side are fixed at band width.
+struct EngineLimits
 {
-    std::vector<OrderBook> book; 
-    TradeLog tradelog;  
+    std::size_t maxSymbols{};
+    std::size_t maxOrdersPerBook{};
+    std::size_t maxOrders{};        // resting across all books
+    PriceBand band{};
+    std::size_t maxTrades{};        // trade ring capacity, rounded up to a power of two
+    bool hugePages{false};
+};
+
+// Room left in a fixed-capacity engine. An unbounded engine reports SIZE_MAX.
+struct EngineHeadroom
+{
+    std::size_t restingOrders{};    // before maxOrders
+    std::size_t tightestBook{};     // free order slots in the fullest book
+    std::size_t rejected{};         // submissions refused for capacity
+};
+
+// What a fixed-capacity engine must reserve for limits.
+std::size_t engineArenaBytes(const EngineLimits& limits);
+
+// Returns limits, or throws std::invalid_argument if a count is zero or the
+// band is empty or not positive.
+const EngineLimits& checkedLimits(const EngineLimits& limits);
+
+// The matching engine, parameterized on where its events go. Sink is a plain
+// member and its hooks are called directly, so the compiler sees through them:
+// MatchingEngine records trades in a TradeLog, BasicMatchingEngine<NullSink>
+// does no event work at all, and a market-data publisher or risk updater can
+// be plugged in the same way without a virtual call. The members are defined
+// in matching_engine_impl.hpp; MatchingEngine and BasicMatchingEngine<NullSink>
+// are instantiated in the library, other sinks include the impl header.
+template<EventSink Sink>
+struct BasicMatchingEngine
+{
+    // Declared first so it is destroyed last, after everything allocated in it.
+    std::unique_ptr<FixedArena> m_arena;
+    std::optional<EngineLimits> m_limits;
+    std::size_t m_capacityRejects{};
+    std::pmr::memory_resource* m_resource;
+    std::pmr::vector<OrderBook> book; 
+    Sink sink;
+    TradeClock clock;
+    CommandLog* commandLog{nullptr};
+    bool m_replaying{false};
     TradeID id {0}; 
-    std::unordered_map<SymbolID, std::string> symbolLookup; 
-    std::unordered_map<OrderID, SymbolID> idToSymbol;
+    std::pmr::unordered_map<SymbolID, std::string> symbolLookup; 
+    OrderIndex orderIndex;
+    std::pmr::vector<TopOfBookCell> m_tops;   // one per book
+    bool m_publishTops{false};
+    bool m_filled{false};                     // this command traded; m_lastFill is its last trade
+    TopOfBook m_lastFill;
+    std::span<Fill> m_fillOut;
+    std::size_t m_fillCount{};
+    std::size_t m_fillsDropped{};
   
-    MatchingEngine(size_t numberofsymbols); 
+    // Sink hooks, silenced while replay() rebuilds state from a command log.
+    void emitTrade(const Trade& trade) { if(!m_replaying) sink.onTrade(trade); }
+    void emitRest(const OrderEvent& order) { if(!m_replaying) sink.onRest(order); }
+    void emitCancel(const OrderEvent& order) { if(!m_replaying) sink.onCancel(order); }
+    void emitReduce(const OrderEvent& order) { if(!m_replaying) sink.onReduce(order); }
+    void emitReject(SymbolID ticker, OrderID orderID, RejectReason reason) { if(!m_replaying) sink.onReject(ticker, orderID, reason); }
+
+    // End of a command on ticker: hands its book's coalesced level changes to
+    // the sink. Compiles away for sinks without onDepth, and a book that is
+    // not tracking depth returns at once.
+    void publishDepth(SymbolID ticker)
+    {
+        if constexpr (DepthPublishing<Sink>)
+        {
+            for(const DepthUpdate& update : book[ticker].collectDepth())
+            {
+                if(!m_replaying) sink.onDepth(ticker, update);
+            }
+        }
+    }
+
+    // End of a command on ticker: refreshes its top-of-book cell when
+    // publishing is on. The writer is the only thread that stores to a cell,
+    // so it reads its own last record back without a retry.
+    void publishTop(SymbolID ticker)
+    {
+        if(!m_publishTops) return;
+        TopOfBook top{};
+        OrderBook& symbolBook = book[ticker];
+        if(symbolBook.hasBids())
+        {
+            const PriceLevel& level = symbolBook.m_BidSide.bestLevel();
+            top.bidPrice = symbolBook.m_BidSide.bestPrice();
+            top.bidQty = level.levelQTY;
+            top.bidOrders = level.orders.count;
+        }
+        if(symbolBook.hasAsks())
+        {
+            const PriceLevel& level = symbolBook.m_AskSide.bestLevel();
+            top.askPrice = symbolBook.m_AskSide.bestPrice();
+            top.askQty = level.levelQTY;
+            top.askOrders = level.orders.count;
+        }
+        const TopOfBook last = m_filled ? m_lastFill : m_tops[ticker].read();
+        top.lastPrice = last.lastPrice;
+        top.lastQty = last.lastQty;
+        top.lastTradeID = last.lastTradeID;
+        m_filled = false;
+        m_tops[ticker].publish(top);
+    }
+
+    // Everything a finished command on ticker publishes.
+    void finishCommand(SymbolID ticker)
+    {
+        publishDepth(ticker);
+        publishTop(ticker);
+        book[ticker].refreshDepthView();
+    }
+
+    // Appends an accepted command to the attached command log, if any.
+    void logCommand(const Command& command) { if(commandLog != nullptr) commandLog->append(command); }
+
+    // What saveSnapshot and snapshotAsync write.
+    SnapshotState snapshotState() const;
+
+    // Books, order index and the sink's state all allocate from resource (an
+    // episode arena, say), which must outlive the engine.
+    BasicMatchingEngine(size_t numberofsymbols, std::pmr::memory_resource* resource = std::pmr::get_default_resource()); 
+
+    // Every book is a ladder over band; throws std::invalid_argument unless
+    // validBand(band).
+    BasicMatchingEngine(size_t numberofsymbols, PriceBand band, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    BasicMatchingEngine();
+
+    // Fixed-capacity engine: all storage for limits is reserved here, in one
+    // arena, and nothing is allocated afterwards. A GTC limit still matches
+    // against a full book; only a residual that would need a slot beyond
+    // maxOrdersPerBook or maxOrders is refused instead of resting.
+    explicit BasicMatchingEngine(const EngineLimits& limits);
+
+    BasicMatchingEngine(BasicMatchingEngine&&) = default;
+
+    BasicMatchingEngine& operator=(BasicMatchingEngine&& other);
+
+    EngineHeadroom headroom() const;
+
+    // Returns every book, the order index and the sink to empty and
+    // restarts trade IDs, keeping all capacity, so the next episode starts
+    // without touching the allocator.
+    void reset();
+
+    // Switches one book to a ladder over band; only allowed while it is empty
+    // and refused for a band validBand turns down.
+    bool configureBook(SymbolID ticker, PriceBand band);
+
+    // Publishes ticker's L2 changes through the sink's onDepth, one update per
+    // level per command; depth is the levels per side to follow, 0 for all.
+    // Tracking survives reset() but not configureBook(). A full-depth tracker
+    // grows with the levels one command touches, which the arena cannot
+    // budget for, so a fixed-capacity engine keeps it on the heap.
+    void trackDepth(SymbolID ticker, std::size_t depth = 0) requires DepthPublishing<Sink>;
 
-    MatchingEngine();
+    // Starts or stops refreshing each book's TopOfBookCell at the end of every
+    // command that touches it. Turn it on before handing topOfBook() to
+    // other threads; starting republishes every book.
+    void publishTopOfBook(bool enabled = true);
 
-    void fillAndRestLimitBid(SymbolID ticker, std::unique_ptr<LimitOrder> limitOrder);
+    // Any thread. The cell for ticker; readers poll it with read()/tryRead()
+    // and never touch the books themselves.
+    const TopOfBookCell& topOfBook(SymbolID ticker) const { return m_tops[ticker]; }
 
-    void fillAndRestLimitAsk(SymbolID ticker, std::unique_ptr<LimitOrder> limitOrder);
+    // Double-buffers ticker's full depth for analytics threads, refreshed at
+    // the end of a command once cadence is reached; a refresh that would have
+    // to wait for a reader is put off to the next command instead. Set it up
+    // before handing depthView() out: configureBook() drops it, reset() keeps
+    // it, and both reset() and loadSnapshot() republish it at once. A
+    // fixed-capacity engine keeps the buffers on the heap, outside its arena.
+    void publishDepthView(SymbolID ticker, DepthViewCadence cadence);
 
-    void fillMarketOrder(SymbolID ticker, OrderSide marketSide, Quantity marketQty, OrderID marketID); 
+    // Any thread. ticker's published depth, nullptr unless publishDepthView()
+    // was called for it; readers acquire() images from it.
+    const PublishedDepth* depthView(SymbolID ticker) const { return book[ticker].m_view.get(); }
+
+    // Sizes the order index for count resting orders across all books.
+    void reserveOrders(std::size_t count);
+
+    // The fill functions return the quantity executed. Each is written once
+    // as a kernel on the aggressor's side S; the OrderSide-taking entry points
+    // pick the kernel and everything below runs without side branches.
+    template<OrderSide S>
+    Quantity fillAndRestLimit(SymbolID ticker, LimitOrder limitOrder);
+
+    template<OrderSide S>
+    Quantity fillMarket(SymbolID ticker, Quantity marketQty, OrderID marketID);
+
+    template<OrderSide S>
+    Quantity sweepAndRecord(SymbolID ticker, OrderID aggressorID, Quantity quantity, Price limit);
+
+    Quantity fillAndRestLimitBid(SymbolID ticker, LimitOrder limitOrder);
+
+    Quantity fillAndRestLimitAsk(SymbolID ticker, LimitOrder limitOrder);
+
+    Quantity fillMarketOrder(SymbolID ticker, OrderSide marketSide, Quantity marketQty, OrderID marketID); 
+
+    void recordFill(SymbolID ticker, OrderSide aggressorSide, OrderID aggressorID, const ExecutionReport& report, Timestamp time);
+
+    // Validate a limit or market order before it reaches the book; a refusal
+    // goes to the sink's onReject.
+    bool acceptsLimit(SymbolID ticker, OrderID orderID, Quantity quantity, Price price);
+    bool acceptsMarket(SymbolID ticker, OrderID orderID, Quantity quantity);
+
+    // Room for one more resting order in ticker's book; always true for an
+    // unbounded engine. Asked only when a GTC residual is about to rest.
+    bool withinLimits(SymbolID ticker);
     
     void submitLimitOrder(SymbolID ticker, OrderSide orderSide, Quantity quantity, OrderID orderID, Price price, LimitType type = LimitType::GTC);
 
     void submitMarketOrder(SymbolID ticker, OrderSide side, Quantity quantity, OrderID id);
 
-    void printTrade(std::size_t index) const;
+    CommandResult execute(const Command& command);
+
+    // Runs commands in order, writing one result per command and every fill
+    // into the caller's buffers; nothing is allocated. Index slots and books
+    // for upcoming commands are prefetched while the current one matches.
+    // Stops at the shorter of commands and results.
+    BatchSummary processBatch(std::span<const Command> commands, std::span<CommandResult> results, std::span<Fill> fills);
+
+    void prefetch(const Command& command) const;
 
-    std::size_t getLogSize() const ;
+    // Matching thread only. Pops up to maxBatch commands from a gateway ring,
+    // applies them in order and returns how many ran.
+    std::size_t drain(MpscRing<Command>& ingress, std::size_t maxBatch = 64);
+
+    // Trade log queries, for sinks that keep one.
+    void printTrade(std::size_t index) const requires TradeLogging<Sink>;
+
+    // Nanoseconds since the epoch at which the trade with this sequence
+    // printed, or nullopt once it has left the trade ring.
+    std::optional<std::int64_t> tradeTime(std::uint64_t sequence) const requires TradeLogging<Sink>;
+
+    std::size_t getLogSize() const requires TradeLogging<Sink>;
 
     std::optional<Price> bestBid(SymbolID ticker) const;
 
     std::optional<Price> bestAsk(SymbolID ticker) const;
+
+    // Top levels of ticker's book into caller arrays; see OrderBook::depth.
+    void depth(SymbolID ticker, std::size_t levels, DepthBuffer& out) const;
+
+    // The same for many books in one call: out[i] receives tickers[i]'s depth.
+    // The next books are prefetched while one is copied, so a caller can lay
+    // every symbol's arrays end to end in one allocation and refresh them all.
+    void depth(std::span<const SymbolID> tickers, std::size_t levels, std::span<DepthBuffer> out) const;
        
     bool FOKVolumeCheck(SymbolID ticker, OrderSide side, Price price, Quantity volume);
 
@@ -44,11 +279,41 @@ struct MatchingEngine
     
     bool reduceOrder(OrderID id, Quantity newQty);
 
-    bool cancelReplace(OrderID id, Quantity newQTY, Price newPrice);    
+    // newID 0 draws the replacement's ID from OrderIDGenerator.
+    bool cancelReplace(OrderID id, Quantity newQTY, Price newPrice, OrderID newID = 0);
+
+    // Rebuilds the books from a command log at startup, through processBatch
+    // with the sink silenced and nothing re-logged, so no trade or event is
+    // published twice. Stops at the end of the log or at a sequence gap, and
+    // moves OrderIDGenerator past every ID the log mentions. Records before
+    // fromSequence are skipped, so a log can be replayed on top of the
+    // snapshot that covers them.
+    ReplaySummary replay(CommandLogReader& log, std::uint64_t fromSequence = 0);
+
+    // Writes the books, order index, trade ID and order ID generator to path
+    // (see snapshot.hpp), tagged with the attached command log's next
+    // sequence. The trade log is not included. Blocks for the whole write.
+    bool saveSnapshot(const std::string& path) const;
+
+    // The same, written by a forked child from a copy-on-write image of the
+    // engine. Matching stalls only for the fork, which copies the page tables
+    // and so grows with the engine's mapped memory; huge pages keep it short.
+    // Every page matching dirties afterwards is copied once.
+    SnapshotJob snapshotAsync(const std::string& path) const;
+
+    // Resets the engine and loads a snapshot taken with the same books and
+    // bands. Returns the command-log sequence to replay from, or nullopt,
+    // leaving the engine empty, when the file is unusable.
+    std::optional<std::uint64_t> loadSnapshot(const std::string& path);
 
     bool hasAsk(SymbolID ticker) const;
 
     bool hasBid(SymbolID ticker) const;
 };
 
+using MatchingEngine = BasicMatchingEngine<TradeLogSink>;
+
+extern template struct BasicMatchingEngine<TradeLogSink>;
+extern template struct BasicMatchingEngine<NullSink>;
+
 
@@ -0,0 +1,640 @@
+#pragma once
+// Member definitions of BasicMatchingEngine. Include this only to instantiate
+// the engine for a sink of your own; MatchingEngine users need just
+// matching_engine.hpp.
+#include "matching_engine.hpp"
+#include "order.hpp"
+#include <algorithm>
+#include <array>
+#include <new>
+#include <utility>
+#include <vector>
+
+    template<EventSink Sink>
+    BasicMatchingEngine<Sink>::BasicMatchingEngine(size_t numberofsymbols, std::pmr::memory_resource* resource)
+    : m_resource{resource}
+    , book(resource)
+    , sink(makeSink<Sink>(TradeLog::kDefaultCapacity, resource))
+    , symbolLookup(resource)
+    , orderIndex(resource)
+    , m_tops(numberofsymbols, resource)
+    {
+        book.reserve(numberofsymbols);
+        for(size_t i{}; i < numberofsymbols; ++i) book.emplace_back(resource);
+    }
+
+    template<EventSink Sink>
+    BasicMatchingEngine<Sink>::BasicMatchingEngine(size_t numberofsymbols, PriceBand band, std::pmr::memory_resource* resource)
+    : m_resource{resource}
+    , book(resource)
+    , sink(makeSink<Sink>(TradeLog::kDefaultCapacity, resource))
+    , symbolLookup(resource)
+    , orderIndex(resource)
+    , m_tops(numberofsymbols, resource)
+    {
+        book.reserve(numberofsymbols);
+        for(size_t i{}; i < numberofsymbols; ++i) book.emplace_back(band, resource);
+    }
+
+    template<EventSink Sink>
+    BasicMatchingEngine<Sink>::BasicMatchingEngine()
+    : BasicMatchingEngine(1)
+    {}
+
+    template<EventSink Sink>
+    BasicMatchingEngine<Sink>::BasicMatchingEngine(const EngineLimits& limits)
+    : m_arena{std::make_unique<FixedArena>(engineArenaBytes(checkedLimits(limits)), limits.hugePages)}
+    , m_limits{limits}
+    , m_resource{m_arena->resource()}
+    , book(m_resource)
+    , sink(makeSink<Sink>(limits.maxTrades, m_resource))
+    , symbolLookup(m_resource)
+    , orderIndex(m_resource)
+    , m_tops(limits.maxSymbols, m_resource)
+    {
+        book.reserve(limits.maxSymbols);
+        for(size_t i{}; i < limits.maxSymbols; ++i)
+        {
+            book.emplace_back(limits.band, m_resource);
+            book.back().reserveOrders(limits.maxOrdersPerBook);
+        }
+        orderIndex.reserve(limits.maxOrders);
+    }
+
+    // Destroy then move-construct: the members must be released before the
+    // arena they were allocated from, which memberwise assignment would not do.
+    template<EventSink Sink>
+    BasicMatchingEngine<Sink>& BasicMatchingEngine<Sink>::operator=(BasicMatchingEngine&& other)
+    {
+        if(this != &other)
+        {
+            this->~BasicMatchingEngine();
+            new (this) BasicMatchingEngine(std::move(other));
+        }
+        return *this;
+    }
+
+    template<EventSink Sink>
+    EngineHeadroom BasicMatchingEngine<Sink>::headroom() const
+    {
+        if(!m_limits) return EngineHeadroom{SIZE_MAX, SIZE_MAX, 0};
+        std::size_t tightest{SIZE_MAX};
+        for(const OrderBook& symbolBook : book) tightest = std::min(tightest, m_limits->maxOrdersPerBook - symbolBook.restingOrders());
+        return EngineHeadroom{m_limits->maxOrders - orderIndex.size(), tightest, m_capacityRejects};
+    }
+
+    template<EventSink Sink>
+    void BasicMatchingEngine<Sink>::reset()
+    {
+        for(OrderBook& symbolBook : book) symbolBook.reset();
+        orderIndex.clear();
+        if constexpr (requires { sink.reset(); }) sink.reset();
+        id = 0;
+        m_capacityRejects = 0;
+        m_filled = false;
+        for(TopOfBookCell& cell : m_tops) cell.publish(TopOfBook{});
+    }
+
+    template<EventSink Sink>
+    bool BasicMatchingEngine<Sink>::configureBook(SymbolID ticker, PriceBand band)
+    {
+        if (m_limits || !validBand(band)) return false;
+        if (book[ticker].hasBids() || book[ticker].hasAsks()) return false;
+        book[ticker] = OrderBook(band, m_resource);
+        return true;
+    }
+
+    template<EventSink Sink>
+    void BasicMatchingEngine<Sink>::trackDepth(SymbolID ticker, std::size_t depth) requires DepthPublishing<Sink>
+    {
+        book[ticker].trackDepth(depth, m_limits ? std::pmr::get_default_resource() : m_resource);
+    }
+
+    template<EventSink Sink>
+    void BasicMatchingEngine<Sink>::publishTopOfBook(bool enabled)
+    {
+        m_publishTops = enabled;
+        m_filled = false;
+        for(SymbolID ticker{}; ticker < book.size(); ++ticker) publishTop(ticker);
+    }
+
+    template<EventSink Sink>
+    void BasicMatchingEngine<Sink>::publishDepthView(SymbolID ticker, DepthViewCadence cadence)
+    {
+        book[ticker].publishDepthView(cadence, m_limits ? std::pmr::get_default_resource() : m_resource);
+    }
+
+    template<EventSink Sink>
+    void BasicMatchingEngine<Sink>::reserveOrders(std::size_t count)
+    {
+        orderIndex.reserve(count);
+    }
+    template<EventSink Sink>
+    bool BasicMatchingEngine<Sink>::acceptsLimit(SymbolID ticker, OrderID orderID, Quantity quantity, Price price)
+    {
+        if(ticker >= book.size())
+        {
+            emitReject(ticker, orderID, RejectReason::UnknownSymbol);
+            return false;
+        }
+        if(orderID == OrderIndex::kEmpty)
+        {
+            emitReject(ticker, orderID, RejectReason::InvalidOrderID);
+            return false;
+        }
+        if(orderIndex.find(orderID) != nullptr)
+        {
+            emitReject(ticker, orderID, RejectReason::DuplicateOrderID);
+            return false;
+        }
+        if(quantity <= 0)
+        {
+            emitReject(ticker, orderID, RejectReason::InvalidQuantity);
+            return false;
+        }
+        if(price <= 0 || !book[ticker].acceptsPrice(price))
+        {
+            emitReject(ticker, orderID, RejectReason::InvalidPrice);
+            return false;
+        }
+        return true;
+    }
+
+    template<EventSink Sink>
+    bool BasicMatchingEngine<Sink>::acceptsMarket(SymbolID ticker, OrderID orderID, Quantity quantity)
+    {
+        if(ticker >= book.size())
+        {
+            emitReject(ticker, orderID, RejectReason::UnknownSymbol);
+            return false;
+        }
+        if(quantity <= 0)
+        {
+            emitReject(ticker, orderID, RejectReason::InvalidQuantity);
+            return false;
+        }
+        return true;
+    }
+
+    // A resting GTC needs one pool slot and one index slot. Trades never count
+    // against a limit: the trade ring overwrites its oldest entries.
+    template<EventSink Sink>
+    bool BasicMatchingEngine<Sink>::withinLimits(SymbolID ticker)
+    {
+        if(!m_limits) return true;
+        const bool fits = book[ticker].restingOrders() < m_limits->maxOrdersPerBook
+                       && orderIndex.size() < m_limits->maxOrders;
+        if(!fits) ++m_capacityRejects;
+        return fits;
+    }
+
+    template<EventSink Sink>
+    void BasicMatchingEngine<Sink>::submitLimitOrder(SymbolID ticker, OrderSide orderSide, Quantity quantity, OrderID orderID, Price price, LimitType type )
+    {
+        if (!acceptsLimit(ticker, orderID, quantity, price)) return;
+        logCommand(Command::limit(ticker, orderSide, quantity, orderID, price, type));
+        LimitOrder limitOrder{orderSide, quantity, orderID, price, type};
+        if(orderSide == OrderSide::Ask) fillAndRestLimitAsk(ticker, limitOrder);
+        else fillAndRestLimitBid(ticker, limitOrder);
+        finishCommand(ticker);
+    }
+     
+    template<EventSink Sink>
+    void BasicMatchingEngine<Sink>::submitMarketOrder(SymbolID ticker, OrderSide side, Quantity quantity, OrderID id)
+    {
+        if (!acceptsMarket(ticker, id, quantity)) return;
+        logCommand(Command::market(ticker, side, quantity, id));
+        fillMarketOrder(ticker, side, quantity, id);
+        finishCommand(ticker);
+    }    
+
+    template<EventSink Sink>
+    CommandResult BasicMatchingEngine<Sink>::execute(const Command& command)
+    {
+        CommandResult result{};
+        switch(command.type)
+        {
+        case Command::Type::Limit:
+        {
+            if(!acceptsLimit(command.ticker, command.id, command.qty, command.price))
+            {
+                result.status = CommandStatus::Rejected;
+                break;
+            }
+            logCommand(command);
+            const std::size_t refusedBefore = m_capacityRejects;
+            LimitOrder limitOrder{command.side, command.qty, command.id, command.price, command.limitType};
+            result.filledQTY = command.side == OrderSide::Ask ? fillAndRestLimitAsk(command.ticker, limitOrder)
+                                                             : fillAndRestLimitBid(command.ticker, limitOrder);
+            if(command.limitType == LimitType::GTC && result.filledQTY < command.qty)
+            {
+                // The residual rested unless it was refused for capacity. A
+                // fill usually frees the slot it needs, but not when the book
+                // was already over its limit, e.g. after loading a snapshot
+                // taken without one, so the order may have traded first.
+                if(m_capacityRejects == refusedBefore) result.restedQTY = command.qty - result.filledQTY;
+                else result.status = result.filledQTY > 0 ? CommandStatus::ResidualRefused : CommandStatus::Rejected;
+            }
+            finishCommand(command.ticker);
+            break;
+        }
+        case Command::Type::Market:
+            if(!acceptsMarket(command.ticker, command.id, command.qty))
+            {
+                result.status = CommandStatus::Rejected;
+                break;
+            }
+            logCommand(command);
+            result.filledQTY = fillMarketOrder(command.ticker, command.side, command.qty, command.id);
+            finishCommand(command.ticker);
+            break;
+        case Command::Type::Cancel:
+            if(!cancelOrder(command.id)) result.status = CommandStatus::NotFound;
+            break;
+        case Command::Type::Reduce:
+            if(orderIndex.find(command.id) == nullptr)
+            {
+                emitReject(command.ticker, command.id, RejectReason::UnknownOrder);
+                result.status = CommandStatus::NotFound;
+            }
+            else if(!reduceOrder(command.id, command.qty)) result.status = CommandStatus::Rejected;
+            break;
+        case Command::Type::CancelReplace:
+            if(!cancelReplace(command.id, command.qty, command.price, command.newID)) result.status = CommandStatus::NotFound;
+            break;
+        }
+        return result;
+    }
+
+    template<EventSink Sink>
+    std::size_t BasicMatchingEngine<Sink>::drain(MpscRing<Command>& ingress, std::size_t maxBatch)
+    {
+        std::size_t drained{};
+        Command command;
+        while(drained < maxBatch && ingress.tryPop(command))
+        {
+            execute(command);
+            ++drained;
+        }
+        return drained;
+    }
+
+    // Warms the index slot (modifies) or the book (new orders) a few commands
+    // ahead of the one currently matching.
+    template<EventSink Sink>
+    void BasicMatchingEngine<Sink>::prefetch(const Command& command) const
+    {
+        switch(command.type)
+        {
+        case Command::Type::Limit:
+        case Command::Type::Market:
+            // Bad tickers are rejected when the command runs.
+            if(command.ticker < book.size()) __builtin_prefetch(&book[command.ticker]);
+            break;
+        case Command::Type::Cancel:
+        case Command::Type::Reduce:
+        case Command::Type::CancelReplace:
+            orderIndex.prefetch(command.id);
+            break;
+        }
+    }
+
+    template<EventSink Sink>
+    BatchSummary BasicMatchingEngine<Sink>::processBatch(std::span<const Command> commands, std::span<CommandResult> results, std::span<Fill> fills)
+    {
+        constexpr std::size_t kPrefetchDistance = 4;
+        m_fillOut = fills;
+        m_fillCount = 0;
+        m_fillsDropped = 0;
+        const std::size_t count = std::min(commands.size(), results.size());
+        for(std::size_t i{}; i < count; ++i)
+        {
+            if(i + kPrefetchDistance < count) prefetch(commands[i + kPrefetchDistance]);
+            const std::size_t firstFill = m_fillCount;
+            results[i] = execute(commands[i]);
+            results[i].firstFill = static_cast<std::uint32_t>(firstFill);
+            results[i].fillCount = static_cast<std::uint32_t>(m_fillCount - firstFill);
+        }
+        BatchSummary summary{count, m_fillCount, m_fillsDropped};
+        m_fillOut = {};
+        m_fillCount = 0;
+        return summary;
+    }
+
+    // Every fill goes through here: the resting order leaves the index once it is
+    // used up, the trade goes to the sink, and a batch in progress gets a copy.
+    template<EventSink Sink>
+    void BasicMatchingEngine<Sink>::recordFill(SymbolID ticker, OrderSide aggressorSide, OrderID aggressorID, const ExecutionReport& report, Timestamp time)
+    {
+        if(report.remainingQTY == 0) orderIndex.erase(report.restingID);
+        const TradeID tradeID = id++;
+        emitTrade(Trade{ticker, tradeID, report.restingPrice, report.executedQTY, aggressorID, report.restingID, aggressorSide, time, clock.source()});
+        if(m_fillCount < m_fillOut.size())
+        {
+            m_fillOut[m_fillCount++] = Fill{tradeID, aggressorID, report.restingID, report.restingPrice, report.executedQTY};
+        }
+        else if(!m_fillOut.empty())
+        {
+            ++m_fillsDropped;
+        }
+    }
+      
+    // Sweeps in chunks of kSweepChunk reports so an aggressor crossing many
+    // levels costs one book call per chunk rather than one per resting order.
+    // The clock is read once, when the first fill comes back, and every trade
+    // of the command carries that stamp; a command that never trades never
+    // reads it.
+    template<EventSink Sink>
+    template<OrderSide S>
+    Quantity BasicMatchingEngine<Sink>::sweepAndRecord(SymbolID ticker, OrderID aggressorID, Quantity quantity, Price limit)
+    {
+        constexpr std::size_t kSweepChunk = 32;
+        std::array<ExecutionReport, kSweepChunk> reports;
+        std::size_t written{};
+        Timestamp time{};
+        bool stamped{false};
+        do
+        {
+            quantity = book[ticker].sweep<S>(quantity, limit, reports, written);
+            if(written > 0 && !stamped)
+            {
+                time = clock.stamp();
+                stamped = true;
+            }
+            for(std::size_t i{}; i < written; ++i) recordFill(ticker, S, aggressorID, reports[i], time);
+            if(written > 0)
+            {
+                m_filled = true;
+                m_lastFill.lastPrice = reports[written - 1].restingPrice;
+                m_lastFill.lastQty = reports[written - 1].executedQTY;
+                m_lastFill.lastTradeID = id - 1;
+            }
+        } while(written == kSweepChunk && quantity > 0);
+        return quantity;
+    }
+
+    template<EventSink Sink>
+    template<OrderSide S>
+    Quantity BasicMatchingEngine<Sink>::fillMarket(SymbolID ticker, Quantity marketQty, OrderID marketID)
+    {
+        return marketQty - sweepAndRecord<S>(ticker, marketID, marketQty, marketLimit(S));
+    }
+
+    template<EventSink Sink>
+    template<OrderSide S>
+    Quantity BasicMatchingEngine<Sink>::fillAndRestLimit(SymbolID ticker, LimitOrder incomingOrder)
+    {
+        Price incomingPrice {incomingOrder.getPrice()};
+        LimitType type {incomingOrder.getType()};
+        OrderID oid {incomingOrder.getOrderID()};
+        const Quantity requested {incomingOrder.getQuantity()};
+        if(type == LimitType::FOK && !book[ticker].FOKVolumeCheck<S>(incomingPrice, requested)) return 0;
+        incomingOrder.setQuantity(sweepAndRecord<S>(ticker, oid, requested, incomingPrice));
+        if(incomingOrder.getQuantity() > 0 && type == LimitType::GTC)
+        {
+          if(!withinLimits(ticker))
+          {
+            emitReject(ticker, oid, RejectReason::CapacityLimit);
+            return requested - incomingOrder.getQuantity();
+          }
+          const OrderHandle handle = book[ticker].add<S>(incomingOrder);
+          // Cannot collide: acceptsLimit turned away IDs that are still live.
+          orderIndex.insert(oid, static_cast<std::uint32_t>(ticker), LookUp{S, handle, incomingPrice});
+          emitRest(OrderEvent{ticker, oid, S, incomingPrice, incomingOrder.getQuantity()});
+        }
+        return requested - incomingOrder.getQuantity();
+    }
+      
+    template<EventSink Sink>
+    Quantity BasicMatchingEngine<Sink>::fillMarketOrder(SymbolID ticker, OrderSide marketSide, Quantity marketQty, OrderID marketID)
+    {
+        if(marketSide == OrderSide::Ask) return fillMarket<OrderSide::Ask>(ticker, marketQty, marketID);
+        return fillMarket<OrderSide::Bid>(ticker, marketQty, marketID);
+    }
+
+    template<EventSink Sink>
+    Quantity BasicMatchingEngine<Sink>::fillAndRestLimitBid(SymbolID ticker, LimitOrder incomingOrder)
+    {
+        return fillAndRestLimit<OrderSide::Bid>(ticker, incomingOrder);
+    }
+
+    template<EventSink Sink>
+    Quantity BasicMatchingEngine<Sink>::fillAndRestLimitAsk(SymbolID ticker, LimitOrder incomingOrder)
+    {
+        return fillAndRestLimit<OrderSide::Ask>(ticker, incomingOrder);
+    }
+
+    template<EventSink Sink>
+    std::optional<SymbolID> BasicMatchingEngine<Sink>::requestModify(OrderID id)
+    {
+      const IndexEntry* entry = orderIndex.find(id);
+      if(entry == nullptr) return std::nullopt;
+      return SymbolID{entry->symbol};
+    }
+    
+    // Each modify resolves the order with a single index probe; the entry carries
+    // the book, side, price and handle, so the book never searches for it.
+    template<EventSink Sink>
+    bool BasicMatchingEngine<Sink>::cancelOrder(OrderID id)
+    {
+        IndexEntry* entry = orderIndex.find(id);
+        if(entry == nullptr)
+        {
+            emitReject(SymbolID{}, id, RejectReason::UnknownOrder);
+            return false;
+        }
+        logCommand(Command::cancel(id, entry->symbol));
+        const LookUp location{entry->location};
+        const Quantity cancelledQTY = book[entry->symbol].cancelOrder(location);
+        const SymbolID ticker{entry->symbol};
+        emitCancel(OrderEvent{ticker, id, location.side(), location.price(), cancelledQTY});
+        orderIndex.erase(entry);
+        finishCommand(ticker);
+        return true;
+    }
+
+    template<EventSink Sink>
+    bool BasicMatchingEngine<Sink>::reduceOrder(OrderID id, Quantity newQty) 
+    {
+      IndexEntry* entry = orderIndex.find(id);
+      if(entry == nullptr)
+      {
+        emitReject(SymbolID{}, id, RejectReason::UnknownOrder);
+        return false;
+      }
+      OrderBook& symbolBook = book[entry->symbol];
+      Quantity restingQTY = symbolBook.restingQuantity(entry->location);
+      if(newQty <= 0 || newQty >= restingQTY)
+      {
+        emitReject(entry->symbol, id, RejectReason::InvalidQuantity);
+        return false;
+      }
+      logCommand(Command::reduce(id, newQty, entry->symbol));
+      symbolBook.reduceQuantity(entry->location, newQty);
+      emitReduce(OrderEvent{entry->symbol, id, entry->location.side(), entry->location.price(), restingQTY - newQty});
+      finishCommand(entry->symbol);
+      return true;
+    }
+
+    // Logged as one command carrying the replacement's ID; the new leg goes
+    // straight to the kernels so it is not logged a second time as a limit.
+    template<EventSink Sink>
+    bool BasicMatchingEngine<Sink>::cancelReplace(OrderID id, Quantity newQTY, Price newPrice, OrderID newID)
+    {
+      IndexEntry* entry = orderIndex.find(id);
+      if(entry == nullptr)
+      {
+        emitReject(SymbolID{}, id, RejectReason::UnknownOrder);
+        return false;
+      }
+      const SymbolID ticker{entry->symbol};
+      const LookUp location{entry->location};
+      const OrderSide side{location.side()};
+      if(newID == 0) newID = OrderIDGenerator::next();
+      logCommand(Command::cancelReplace(id, newQTY, newPrice, ticker, newID));
+      const Quantity cancelledQTY = book[ticker].cancelOrder(location);
+      emitCancel(OrderEvent{ticker, id, side, location.price(), cancelledQTY});
+      orderIndex.erase(entry);
+      if(acceptsLimit(ticker, newID, newQTY, newPrice))
+      {
+        const LimitOrder replacement{side, newQTY, newID, newPrice, LimitType::GTC};
+        if(side == OrderSide::Ask) fillAndRestLimitAsk(ticker, replacement);
+        else fillAndRestLimitBid(ticker, replacement);
+      }
+      finishCommand(ticker);
+      return true;
+    }
+
+    template<EventSink Sink>
+    ReplaySummary BasicMatchingEngine<Sink>::replay(CommandLogReader& log, std::uint64_t fromSequence)
+    {
+        constexpr std::size_t kChunk = 4096;
+        std::vector<CommandRecord> records(kChunk);
+        std::vector<Command> commands(kChunk);
+        std::vector<CommandResult> results(kChunk);
+        CommandLog* attached = std::exchange(commandLog, nullptr);
+        m_replaying = true;
+        ReplaySummary summary;
+        summary.nextSequence = fromSequence;
+        OrderID highest{};
+        while(const std::size_t count = log.read(records))
+        {
+            std::size_t first{};
+            while(first < count && records[first].sequence < fromSequence) ++first;
+            std::size_t usable{};
+            for(; first + usable < count && records[first + usable].sequence == summary.nextSequence + usable; ++usable)
+            {
+                commands[usable] = CommandCodec::decode(records[first + usable]);
+                highest = std::max({highest, commands[usable].id, commands[usable].newID});
+            }
+            processBatch(std::span<const Command>(commands.data(), usable), results, {});
+            summary.commands += usable;
+            summary.nextSequence += usable;
+            if(first + usable < count)
+            {
+                summary.gap = true;
+                break;
+            }
+        }
+        m_replaying = false;
+        commandLog = attached;
+        OrderIDGenerator::advancePast(highest);
+        return summary;
+    }
+   
+    template<EventSink Sink>
+    SnapshotState BasicMatchingEngine<Sink>::snapshotState() const
+    {
+        return SnapshotState{book, orderIndex, id, commandLog != nullptr ? commandLog->nextSequence() : 0, OrderIDGenerator::peek()};
+    }
+
+    template<EventSink Sink>
+    bool BasicMatchingEngine<Sink>::saveSnapshot(const std::string& path) const
+    {
+        const std::string tmpPath = path + ".tmp";
+        return writeSnapshot(path.c_str(), tmpPath.c_str(), snapshotState());
+    }
+
+    template<EventSink Sink>
+    SnapshotJob BasicMatchingEngine<Sink>::snapshotAsync(const std::string& path) const
+    {
+        return forkSnapshot(path, snapshotState());
+    }
+
+    template<EventSink Sink>
+    std::optional<std::uint64_t> BasicMatchingEngine<Sink>::loadSnapshot(const std::string& path)
+    {
+        reset();
+        const MappedSnapshot snapshot(path);
+        if(!restoreSnapshot(snapshot, book, orderIndex)) return std::nullopt;
+        id = snapshot.header().tradeID;
+        OrderIDGenerator::reset(snapshot.header().nextOrderID);
+        for(SymbolID ticker{}; ticker < book.size(); ++ticker)
+        {
+            publishTop(ticker);
+            book[ticker].republishDepth();
+            book[ticker].republishDepthView();
+        }
+        return snapshot.header().commandSequence;
+    }
+
+    template<EventSink Sink>
+    void BasicMatchingEngine<Sink>::printTrade(std::size_t index) const requires TradeLogging<Sink>
+    {
+        sink.tradelog.printTrade(index, clock);
+    }
+
+    template<EventSink Sink>
+    std::optional<std::int64_t> BasicMatchingEngine<Sink>::tradeTime(std::uint64_t sequence) const requires TradeLogging<Sink>
+    {
+        const Trade* trade = sink.tradelog.find(sequence);
+        if(trade == nullptr) return std::nullopt;
+        return clock.toNanos(trade->m_Time, trade->m_TimeSource);
+    }
+    template<EventSink Sink>
+    std::size_t BasicMatchingEngine<Sink>::getLogSize() const requires TradeLogging<Sink>
+    {
+        return sink.tradelog.getTradeLogSize();
+    }
+
+    template<EventSink Sink>
+    std::optional<Price> BasicMatchingEngine<Sink>::bestBid(SymbolID ticker) const
+    {
+        return book[ticker].bestBid();
+    }
+
+    template<EventSink Sink>
+    std::optional<Price> BasicMatchingEngine<Sink>::bestAsk(SymbolID ticker) const
+    {
+        return book[ticker].bestAsk();
+    }
+
+    template<EventSink Sink>
+    void BasicMatchingEngine<Sink>::depth(SymbolID ticker, std::size_t levels, DepthBuffer& out) const
+    {
+        book[ticker].depth(levels, out);
+    }
+
+    template<EventSink Sink>
+    void BasicMatchingEngine<Sink>::depth(std::span<const SymbolID> tickers, std::size_t levels, std::span<DepthBuffer> out) const
+    {
+        constexpr std::size_t kPrefetchDistance = 2;
+        const std::size_t count = std::min(tickers.size(), out.size());
+        for(std::size_t i{}; i < count; ++i)
+        {
+            if(i + kPrefetchDistance < count) __builtin_prefetch(&book[tickers[i + kPrefetchDistance]]);
+            book[tickers[i]].depth(levels, out[i]);
+        }
+    }
+
+    template<EventSink Sink>
+    bool BasicMatchingEngine<Sink>::hasBid(SymbolID ticker) const
+    {
+        return book[ticker].hasBids();
+    }
+
+    template<EventSink Sink>
+    bool BasicMatchingEngine<Sink>::hasAsk(SymbolID ticker) const
+    {
+        return book[ticker].hasAsks();
+    }
@@ -0,0 +1,111 @@
+#pragma once
+#include "spsc_ring.hpp"
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+// Bounded multi-producer single-consumer ring for handing fixed-size records
+// (Commands) from gateway threads to the matching thread. Each slot carries a
+// sequence number: producers claim a position with one CAS on the tail, write
+// the slot and publish it by bumping its sequence; the consumer reads slots in
+// order and hands them back by advancing their sequence a lap. Slots are padded
+// to a cache line so producers filling neighbouring slots do not false-share.
+//
+// Producers never take a lock. When the ring is full, tryPush fails at once
+// and counts a rejection: the gateway is expected to reject the order back to
+// its client (reject mode), or call push() to yield until a slot frees up
+// (back-pressure mode). A producer stalled between claiming and publishing a
+// slot holds up the consumer at that slot until it resumes.
+template<typename T>
+class MpscRing
+{
+    private:
+    struct alignas(kCacheLine) Slot
+    {
+        std::atomic<std::size_t> sequence;
+        T value;
+    };
+
+    std::unique_ptr<Slot[]> m_slots;
+    std::size_t m_mask;
+
+    alignas(kCacheLine) std::atomic<std::size_t> m_tail{0};
+    alignas(kCacheLine) std::size_t m_head{0}; // consumer only
+    alignas(kCacheLine) std::atomic<std::uint64_t> m_rejected{0};
+
+    bool tryEnqueue(const T& value)
+    {
+        std::size_t pos = m_tail.load(std::memory_order_relaxed);
+        while (true)
+        {
+            Slot& slot = m_slots[pos & m_mask];
+            const std::size_t sequence = slot.sequence.load(std::memory_order_acquire);
+            const auto lag = static_cast<std::ptrdiff_t>(sequence - pos);
+            if (lag == 0)
+            {
+                if (m_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    slot.value = value;
+                    slot.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (lag < 0)
+            {
+                return false;
+            }
+            else
+            {
+                pos = m_tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    public:
+    explicit MpscRing(std::size_t capacity)
+    : m_slots(std::make_unique<Slot[]>(std::bit_ceil(capacity)))
+    , m_mask(std::bit_ceil(capacity) - 1)
+    {
+        for (std::size_t i = 0; i <= m_mask; ++i) m_slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    // Any thread. Returns false, and counts a rejection, when the ring is full.
+    bool tryPush(const T& value)
+    {
+        if (tryEnqueue(value)) return true;
+        m_rejected.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    // Any thread. Yields until the value fits; nothing is counted as rejected.
+    void push(const T& value)
+    {
+        while (!tryEnqueue(value)) std::this_thread::yield();
+    }
+
+    // Consumer only. Returns false when the next slot is not yet published.
+    bool tryPop(T& out)
+    {
+        Slot& slot = m_slots[m_head & m_mask];
+        if (slot.sequence.load(std::memory_order_acquire) != m_head + 1) return false;
+        out = slot.value;
+        slot.sequence.store(m_head + m_mask + 1, std::memory_order_release);
+        ++m_head;
+        return true;
+    }
+
+    // Consumer only. Pops up to max published values in order.
+    std::size_t popBatch(T* out, std::size_t max)
+    {
+        std::size_t count = 0;
+        while (count < max && tryPop(out[count])) ++count;
+        return count;
+    }
+
+    std::uint64_t rejected() const { return m_rejected.load(std::memory_order_relaxed); }
+
+    std::size_t capacity() const { return m_mask + 1; }
+};
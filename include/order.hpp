@@ -5,7 +5,7 @@ using Price = int32_t;
 using Quantity = uint32_t;
 using OrderID = int32_t;
 
-enum class OrderSide
+enum class OrderSide : std::uint8_t
 {
     Bid,
     Ask,
@@ -14,6 +14,17 @@ enum class OrderSide
 struct OrderIDGenerator
 {
     static OrderID next();
+
+    // Every later next() returns an ID above id. Recovery calls this so fresh
+    // IDs cannot collide with ones already in a command log.
+    static void advancePast(OrderID id);
+
+    // The ID the next call to next() returns.
+    static OrderID peek();
+
+    // Makes next() continue from nextID, e.g. when restoring a snapshot.
+    static void reset(OrderID nextID);
+
     static int max;
 };
 
@@ -34,6 +45,8 @@ class LimitOrder
     LimitType m_LimitType{};
 
     public: 
+    LimitOrder() = default;
+
     LimitOrder(OrderSide side, Quantity quantity, OrderID orderid, Price price, LimitType type)
     : m_OrderSide{side}
     , m_Quantity{quantity}
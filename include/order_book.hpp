@@ -1,41 +1,185 @@
 #pragma once 
 #include "order.hpp"
-#include <map>
+#include "book_side.hpp"
+#include "depth_tracker.hpp"
+#include "depth_view.hpp"
+#include "order_pool.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <limits>
 #include <memory>
+#include <memory_resource>
 #include <optional>
-#include <unordered_map>
-#include <list>
+#include <span>
 
 struct ExecutionReport
 {
     Price restingPrice;
     OrderID restingID;
     Quantity executedQTY; 
+    Quantity remainingQTY; // left on the resting order; 0 means it was removed
 };
 
-struct PriceLevel 
+// Caller-owned structure-of-arrays output for depth queries: each side's
+// prices and aggregated quantities, best first. depth() fills at most the
+// shorter array of a side and sets bids/asks to the levels written.
+struct DepthBuffer
 {
-  std::list<std::unique_ptr<LimitOrder>> orders;
-  Quantity levelQTY;
+    std::span<Price> bidPrices;
+    std::span<Quantity> bidQuantities;
+    std::span<Price> askPrices;
+    std::span<Quantity> askQuantities;
+    std::size_t bids{};
+    std::size_t asks{};
 };
+
+// What the book needs to reach a resting order without searching for it,
+// packed into 8 bytes. Resting prices are always positive, so 31 bits hold any
+// of them and the side takes the last bit.
 struct LookUp
 {
-    OrderSide side;
-    std::list<std::unique_ptr<LimitOrder>>::iterator orderIT;
-    Price price;
-    Quantity qty;
+    OrderHandle handle{kNullHandle};
+    std::uint32_t priceBits : 31 {};
+    std::uint32_t askBit : 1 {};
+
+    LookUp() = default;
+
+    LookUp(OrderSide orderSide, OrderHandle orderHandle, Price restingPrice)
+    : handle{orderHandle}
+    , priceBits{static_cast<std::uint32_t>(restingPrice) & 0x7FFF'FFFFu}
+    , askBit{orderSide == OrderSide::Ask}
+    {}
+
+    OrderSide side() const { return askBit ? OrderSide::Ask : OrderSide::Bid; }
+
+    Price price() const { return static_cast<Price>(priceBits); }
 };
 
+static_assert(sizeof(LookUp) == 8);
+
+inline constexpr OrderSide opposite(OrderSide side)
+{
+    return side == OrderSide::Bid ? OrderSide::Ask : OrderSide::Bid;
+}
+
+// Sweep limit for an order that takes any price.
+inline constexpr Price marketLimit(OrderSide aggressorSide)
+{
+    return aggressorSide == OrderSide::Bid ? std::numeric_limits<Price>::max()
+                                           : std::numeric_limits<Price>::min();
+}
+
 struct OrderBook 
 {
      
-    std::map<Price, PriceLevel, std::greater<Price>> m_BidSide;
-    std::map<Price, PriceLevel, std::less<Price>> m_AskSide; 
-    std::unordered_map<OrderID, LookUp> m_lookup;
+    BookSide<std::greater<Price>> m_BidSide;
+    BookSide<std::less<Price>> m_AskSide; 
+    OrderPool m_pool;
+    DepthTracker m_depthFeed;
+    std::unique_ptr<PublishedDepth> m_view;   // null unless publishDepthView() was called
+
+    // Every level, ladder array and pool chunk the book allocates comes from
+    // resource, which must outlive the book.
+    explicit OrderBook(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    // Ladder book: both sides are dense arrays over band and only prices inside
+    // it can rest. Throws std::invalid_argument unless validBand(band).
+    explicit OrderBook(PriceBand band, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    // Empties both sides and the pool while keeping their storage. The next
+    // collectDepth() reports every level the book had as removed, and the
+    // published view, if any, is refreshed so readers see the empty book.
+    void reset();
+
+    // L2 change stream: every function below that changes a level's quantity
+    // notes it, and collectDepth() returns the coalesced updates since the
+    // last call. depth is the number of levels per side to follow, 0 for all;
+    // see DepthTracker. Off by default. The tracker's buffers come from
+    // resource from here on.
+    void trackDepth(std::size_t depth, std::pmr::memory_resource* resource);
+
+    std::span<const DepthUpdate> collectDepth();
+
+    // Reports every level at the next collectDepth(), for levels put in place
+    // outside a command such as a snapshot restore.
+    void republishDepth() { m_depthFeed.touchAll(m_BidSide, m_AskSide); }
+
+    // Full-depth images for reader threads, refreshed by refreshDepthView() at
+    // cadence. The buffers come from resource; a ladder book sizes them to its
+    // band up front, a std::map book grows them when it gains levels. Calling
+    // it again replaces the view, so do it before readers hold the old one.
+    void publishDepthView(DepthViewCadence cadence, std::pmr::memory_resource* resource);
+
+    // End of a command: counts it and refreshes the published view if the
+    // cadence says so. Does nothing when no view is published.
+    void refreshDepthView()
+    {
+        if (m_view != nullptr && m_view->due()) m_view->refresh(m_BidSide, m_AskSide);
+    }
+
+    // Refreshes the published view now, whatever the cadence, for changes
+    // made outside a command such as a snapshot restore.
+    void republishDepthView()
+    {
+        if (m_view != nullptr) m_view->refresh(m_BidSide, m_AskSide);
+    }
+
+    bool isLadder() const;
+
+    // The ladder band, or nullopt for a std::map book.
+    std::optional<PriceBand> band() const;
+
+    bool acceptsPrice(Price price) const;
+
+    // Side-specialized kernels. S is the side of the order being rested,
+    // cancelled or reduced, or of the aggressor when matching; the BookSide it
+    // touches and that side's comparator are fixed at compile time. The
+    // OrderSide-taking functions below are thin wrappers that dispatch once.
+    template<OrderSide S>
+    auto& ownSide()
+    {
+        if constexpr (S == OrderSide::Bid) return m_BidSide;
+        else return m_AskSide;
+    }
+
+    template<OrderSide S>
+    auto& oppositeSide()
+    {
+        if constexpr (S == OrderSide::Bid) return m_AskSide;
+        else return m_BidSide;
+    }
+
+    template<OrderSide S>
+    OrderHandle add(const LimitOrder& order);
+
+    template<OrderSide Aggressor>
+    std::optional<ExecutionReport> consumeBest(Quantity quantity);
+
+    // Takes up to quantity from the side opposite the aggressor, best level
+    // first and FIFO within a level, at prices no worse than limit. Writes one
+    // report per resting order touched into out, sets written, and returns the
+    // quantity left over. Stops early only when out is full.
+    template<OrderSide Aggressor>
+    Quantity sweep(Quantity quantity, Price limit, std::span<ExecutionReport> out, std::size_t& written);
+
+    template<OrderSide Aggressor>
+    bool FOKVolumeCheck(Price price, Quantity volume);
+
+    // Returns the quantity that left the book.
+    template<OrderSide S>
+    Quantity cancelOrder(OrderHandle handle, Price price);
+
+    template<OrderSide S>
+    void reduceQuantity(OrderHandle handle, Price price, Quantity newQTY);
         
-    void addBid(std::unique_ptr<LimitOrder> order) ;
+    // Rest an order; the returned handle plus side and price locate it later.
+    OrderHandle addBid(const LimitOrder& order) ;
+
+    OrderHandle addAsk(const LimitOrder& order) ; 
 
-    void addAsk(std::unique_ptr<LimitOrder> order) ; 
+    void reserveOrders(std::size_t count);
+
+    std::size_t restingOrders() const;
 
     bool hasAsks() const ;
 
@@ -45,17 +189,21 @@ struct OrderBook
 
     std::optional<Price> bestAsk() const;
 
+    // The best levels (at most levels per side) into out, from the levels'
+    // running totals; nothing is allocated and no order queue is read.
+    void depth(std::size_t levels, DepthBuffer& out) const;
+
     std::optional<ExecutionReport> consumeBestAsk(Quantity quantity);
 
     std::optional<ExecutionReport> consumeBestBid(Quantity quantity);
-    
-    LookUp infoFromID(OrderID id);
 
+    Quantity sweep(OrderSide aggressorSide, Quantity quantity, Price limit, std::span<ExecutionReport> out, std::size_t& written);
+    
     bool FOKVolumeCheck(OrderSide side, Price price, Quantity volume);
 
-    bool orderExists(OrderID id);
+    Quantity restingQuantity(const LookUp& info) const;
 
-    void cancelOrder(OrderID id);
+    Quantity cancelOrder(const LookUp& info);
           
-    void reduceQuantity(OrderID id, Quantity newQTY);
+    void reduceQuantity(const LookUp& info, Quantity newQTY);
 };
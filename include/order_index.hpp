@@ -0,0 +1,84 @@
+#pragma once
+#include "order.hpp"
+#include "order_book.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory_resource>
+#include <span>
+#include <vector>
+
+// Where a resting order lives: its book, plus the side/price/handle that book
+// needs to reach it. 16 bytes, so a probe run of four slots is one cache line.
+struct IndexEntry
+{
+    OrderID id;
+    std::uint32_t symbol;
+    LookUp location;
+};
+
+static_assert(sizeof(IndexEntry) == 16);
+
+// Engine-wide OrderID -> IndexEntry map. Open addressing with linear probing over
+// a flat power-of-two array, entries stored inline, so a cancel is one hash and a
+// short run of adjacent slots. Deletion shifts the following run back instead of
+// leaving tombstones, so probe lengths never degrade under churn. The table grows
+// by doubling past half full; reserve() sizes it up front so it never has to.
+class OrderIndex
+{
+    public:
+    // Marks a free slot, so no order may carry this ID; the engine rejects it.
+    static constexpr OrderID kEmpty = std::numeric_limits<OrderID>::min();
+
+    private:
+    std::pmr::vector<IndexEntry> m_slots;
+    std::size_t m_mask{};
+    unsigned m_shift{64};
+    std::size_t m_size{};
+
+    std::size_t home(OrderID id) const
+    {
+        // Fibonacci hashing spreads the sequential IDs the generator hands out.
+        return static_cast<std::size_t>(
+            (static_cast<std::uint64_t>(static_cast<std::uint32_t>(id)) * 0x9E3779B97F4A7C15ull)
+            >> m_shift);
+    }
+
+    void rehash(std::size_t capacity);
+
+    public:
+    explicit OrderIndex(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+    : m_slots(resource)
+    {}
+
+    void reserve(std::size_t count);
+
+    // Removes every entry but keeps the table at its current capacity.
+    void clear();
+
+    // Adds an entry for id, which must not be kEmpty. Returns false and leaves
+    // the table alone when id already has one: overwriting would strand the
+    // order it points at.
+    bool insert(OrderID id, std::uint32_t symbol, LookUp location);
+
+    IndexEntry* find(OrderID id);
+
+    // entry must come from find() with no insert or erase in between.
+    void erase(IndexEntry* entry);
+
+    bool erase(OrderID id);
+
+    std::size_t size() const;
+
+    std::size_t capacity() const;
+
+    // Pulls id's home slot towards the cache ahead of a find().
+    void prefetch(OrderID id) const;
+
+    // Snapshot support: the raw slot array, and restoring one verbatim. The
+    // slot count must be a power of two; size is the number of occupied slots.
+    std::span<const IndexEntry> slots() const { return m_slots; }
+
+    void restore(std::span<const IndexEntry> slots, std::size_t size);
+};
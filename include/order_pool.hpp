@@ -0,0 +1,129 @@
+#pragma once
+#include "order.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <span>
+#include <vector>
+
+// Handle to a resting order slot. 32 bits rather than a pointer keeps the queue
+// links inside the record small; kNullHandle terminates a queue.
+using OrderHandle = std::uint32_t;
+inline constexpr OrderHandle kNullHandle = UINT32_MAX;
+
+// A resting order together with its FIFO links, packed into 16 bytes so four
+// share a cache line. Side and price belong to the level the order is queued
+// in and a resting order is always GTC, so only the ID and open quantity are
+// kept. While the slot is free, next threads the pool's free list instead.
+struct OrderNode
+{
+    OrderID id{};
+    Quantity qty{};
+    OrderHandle prev{kNullHandle};
+    OrderHandle next{kNullHandle};
+};
+
+static_assert(sizeof(OrderNode) == 16);
+
+// Slab of OrderNodes carved out of fixed-size chunks. Slots are recycled through
+// an intrusive free list, so after warm-up resting an order costs no heap
+// allocation, and chunks never move so references stay valid while the pool grows.
+// Chunks come from the pool's memory resource.
+class OrderPool
+{
+    public:
+    static constexpr std::size_t kChunkShift = 10;
+    static constexpr std::size_t kChunkSize = std::size_t{1} << kChunkShift;
+
+    private:
+    std::pmr::vector<std::pmr::vector<OrderNode>> m_chunks;
+    OrderHandle m_freeHead{kNullHandle};
+    std::size_t m_carved{};
+    std::size_t m_free{};
+
+    void grow();
+
+    public:
+    explicit OrderPool(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+    : m_chunks(resource)
+    {}
+
+    OrderNode& operator[](OrderHandle handle)
+    {
+        return m_chunks[handle >> kChunkShift][handle & (kChunkSize - 1)];
+    }
+
+    const OrderNode& operator[](OrderHandle handle) const
+    {
+        return m_chunks[handle >> kChunkShift][handle & (kChunkSize - 1)];
+    }
+
+    void reserve(std::size_t count);
+
+    OrderHandle create(OrderID id, Quantity qty);
+
+    void destroy(OrderHandle handle);
+
+    // Frees count slots already chained through next, first to last, in one
+    // splice onto the free list.
+    void destroyChain(OrderHandle first, OrderHandle last, std::size_t count);
+
+    std::size_t available() const;
+
+    // Frees every slot at once; the chunks are kept for reuse.
+    void clear();
+
+    // Slots allocated so far, in use or free.
+    std::size_t capacity() const { return m_chunks.size() * kChunkSize; }
+
+    // Snapshot support. Slots [0, carved()) have been handed out at least once;
+    // those not resting are chained from freeHead(). Handles are plain slot
+    // numbers, so copying the carved slots back with restore() brings every
+    // queue link and index entry back to life unchanged.
+    std::size_t carved() const { return m_carved; }
+
+    OrderHandle freeHead() const { return m_freeHead; }
+
+    std::span<const OrderNode> chunk(std::size_t index) const { return m_chunks[index]; }
+
+    // Replaces the contents with nodes as the carved slots, freeCount of them
+    // on the free list starting at freeHead.
+    void restore(std::span<const OrderNode> nodes, OrderHandle freeHead, std::size_t freeCount);
+};
+
+// FIFO of resting orders at one price level. The links live in the OrderNodes
+// themselves, so walking a level is one hop per order and erase is O(1). count
+// is kept alongside so a level's order count never needs a walk either.
+struct OrderQueue
+{
+    OrderHandle head{kNullHandle};
+    OrderHandle tail{kNullHandle};
+    std::uint32_t count{};
+
+    bool empty() const { return head == kNullHandle; }
+
+    OrderHandle front() const { return head; }
+
+    void pushBack(OrderPool& pool, OrderHandle handle);
+
+    void erase(OrderPool& pool, OrderHandle handle);
+
+    void popFront(OrderPool& pool)
+    {
+        --count;
+        head = pool[head].next;
+        if (head == kNullHandle) tail = kNullHandle;
+        else pool[head].prev = kNullHandle;
+    }
+
+    // Unlinks every order ahead of newHead (kNullHandle empties the queue), of
+    // which there are dropped. The caller owns the detached chain, which still
+    // runs from the old head via next.
+    void dropFront(OrderPool& pool, OrderHandle newHead, std::uint32_t dropped)
+    {
+        count -= dropped;
+        head = newHead;
+        if (head == kNullHandle) tail = kNullHandle;
+        else pool[head].prev = kNullHandle;
+    }
+};
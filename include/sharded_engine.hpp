@@ -0,0 +1,96 @@
+#pragma once
+#include "command.hpp"
+#include "matching_engine.hpp"
+#include "spsc_ring.hpp"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <vector>
+
+// Symbols partitioned across worker threads. Shard s owns every ticker with
+// ticker % shardCount == s: its own MatchingEngine (books, order index, trade
+// log) and the trade-ID range starting at s << kTradeIDShardShift. Commands are
+// routed to the owning shard through a per-shard SPSC ring, so shards never
+// share mutable state and scale with cores.
+//
+// A shard's engine holds only its own books, numbered by localTicker(), so
+// inside a shard (its books, trades and events) a symbol goes by its local
+// number. Each worker builds its engine after pinning itself, so the books are
+// first touched on the core that matches them; the constructor returns once
+// every shard is built.
+//
+// All submit calls must come from one thread (each ring has a single
+// producer). Modifies carry the ticker because routing is by symbol, not by
+// order ID. Shard engines may only be inspected after flush() while no one is
+// submitting.
+class ShardedEngine
+{
+    public:
+    static constexpr unsigned kTradeIDShardShift = 48;
+
+    private:
+    struct Shard
+    {
+        std::optional<MatchingEngine> engine;   // built by the worker
+        SpscRing<Command> inbox;
+        std::uint64_t submitted{};
+        alignas(kCacheLine) std::atomic<std::uint64_t> processed{0};
+        std::atomic<bool> ready{false};
+        std::thread worker;
+
+        explicit Shard(std::size_t queueCapacity);
+    };
+
+    std::vector<std::unique_ptr<Shard>> m_shards;
+    std::atomic<bool> m_running{true};
+
+    void run(Shard& shard, std::size_t index, std::size_t symbols, std::optional<PriceBand> band, std::size_t core, bool pin);
+
+    public:
+    // Throws std::invalid_argument when shardCount is 0.
+    ShardedEngine(std::size_t numberofsymbols, std::size_t shardCount,
+                  std::optional<PriceBand> band = std::nullopt,
+                  std::size_t queueCapacity = 1 << 16, bool pinThreads = true);
+
+    ~ShardedEngine();
+
+    ShardedEngine(const ShardedEngine&) = delete;
+    ShardedEngine& operator=(const ShardedEngine&) = delete;
+
+    // Spins while the owning shard's ring is full.
+    void submit(const Command& command);
+
+    void submitLimitOrder(SymbolID ticker, OrderSide side, Quantity quantity, OrderID id, Price price, LimitType type = LimitType::GTC);
+
+    void submitMarketOrder(SymbolID ticker, OrderSide side, Quantity quantity, OrderID id);
+
+    void cancelOrder(SymbolID ticker, OrderID id);
+
+    void reduceOrder(SymbolID ticker, OrderID id, Quantity newQty);
+
+    // The replacement's ID is drawn here, on the submitting thread, so workers
+    // never touch the shared ID generator.
+    void cancelReplace(SymbolID ticker, OrderID id, Quantity newQty, Price newPrice);
+
+    // Blocks until every shard has applied everything submitted so far.
+    void flush();
+
+    // Drains outstanding commands and joins the workers. Called by the destructor.
+    void stop();
+
+    std::size_t shardCount() const;
+
+    std::size_t shardOf(SymbolID ticker) const;
+
+    // ticker's book number inside its shard's engine.
+    SymbolID localTicker(SymbolID ticker) const;
+
+    // Only valid after flush(); look books up by localTicker().
+    const MatchingEngine& engineFor(SymbolID ticker) const;
+
+    const MatchingEngine& shard(std::size_t index) const;
+
+    std::size_t getLogSize() const;
+};
@@ -0,0 +1,155 @@
+#pragma once
+#include "order_book.hpp"
+#include "order_index.hpp"
+#include "trade.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <sys/types.h>
+
+// Engine snapshot file format, version 2. Host byte order; every section starts
+// on a 64-byte boundary and is addressed by its offset from the start of the
+// file, so the file is used in place once mapped.
+//
+//   SnapshotHeader
+//   SnapshotBook[bookCount]                       at booksOffset
+//   per book: SnapshotLevel[bidLevels + askLevels] at levelsOffset, bids then
+//             asks, each best first
+//             OrderNode[carved]                   at nodesOffset
+//   IndexEntry[indexSlots]                        at indexOffset
+//
+// Orders are stored as the book's pool slots, links and all, and the index as
+// its raw slot array. Both refer to orders by pool handle, which is a slot
+// number rather than an address, so restoring is a copy of each array and one
+// insert per price level: no queue is rebuilt and nothing is rehashed.
+struct SnapshotHeader
+{
+    char magic[8];                  // "OBSNAPSH"
+    std::uint32_t version;          // kVersion in snapshot.cpp, currently 2
+    std::uint32_t bookCount;
+    std::uint64_t fileBytes;
+    std::uint64_t tradeID;          // the engine's next TradeID
+    std::uint64_t commandSequence;  // first command-log sequence not reflected
+    OrderID nextOrderID;            // OrderIDGenerator::peek()
+    std::uint32_t reserved;
+    std::uint64_t booksOffset;
+    std::uint64_t indexOffset;
+    std::uint64_t indexSlots;
+    std::uint64_t indexSize;
+};
+
+struct SnapshotBook
+{
+    std::uint32_t isLadder;
+    Price minPrice;                 // ladder band, 0 for a std::map book
+    Price maxPrice;
+    OrderHandle freeHead;
+    std::uint32_t bidLevels;
+    std::uint32_t askLevels;
+    std::uint64_t carved;
+    std::uint64_t freeCount;
+    std::uint64_t levelsOffset;
+    std::uint64_t nodesOffset;
+};
+
+struct SnapshotLevel
+{
+    Price price;
+    Quantity levelQTY;
+    OrderHandle head;
+    OrderHandle tail;
+    std::uint32_t orderCount;
+};
+
+static_assert(sizeof(SnapshotHeader) == 80);
+static_assert(sizeof(SnapshotBook) == 56);
+static_assert(sizeof(SnapshotLevel) == 20);
+
+// What goes into a snapshot.
+struct SnapshotState
+{
+    std::span<const OrderBook> books;
+    const OrderIndex& index;
+    TradeID tradeID{};
+    std::uint64_t commandSequence{};
+    OrderID nextOrderID{};
+};
+
+// Writes state to tmpPath and renames it over path, so a reader never sees a
+// partial snapshot. Allocates nothing, which keeps it safe in a forked child.
+// Returns false on an I/O error.
+bool writeSnapshot(const char* path, const char* tmpPath, const SnapshotState& state);
+
+// A snapshot being written by a forked child from its copy-on-write view of
+// the parent, so the parent only pays for the fork itself.
+class SnapshotJob
+{
+    private:
+    pid_t m_pid{-1};
+
+    public:
+    SnapshotJob() = default;
+
+    explicit SnapshotJob(pid_t pid)
+    : m_pid{pid}
+    {}
+
+    // False if the fork failed.
+    bool started() const { return m_pid > 0; }
+
+    // Blocks until the child exits; true when the snapshot was written.
+    bool wait();
+};
+
+// Forks; the child writes state to path and exits.
+SnapshotJob forkSnapshot(const std::string& path, const SnapshotState& state);
+
+// A snapshot file mapped read-only and checked: the header, and that every
+// section lies inside the file.
+class MappedSnapshot
+{
+    private:
+    const std::byte* m_base{nullptr};
+    std::size_t m_bytes{};
+
+    template<typename T>
+    std::span<const T> section(std::uint64_t offset, std::uint64_t count) const
+    {
+        return {reinterpret_cast<const T*>(m_base + offset), static_cast<std::size_t>(count)};
+    }
+
+    bool inFile(std::uint64_t offset, std::uint64_t count, std::size_t size) const;
+
+    bool check() const;
+
+    public:
+    explicit MappedSnapshot(const std::string& path);
+
+    ~MappedSnapshot();
+
+    MappedSnapshot(const MappedSnapshot&) = delete;
+    MappedSnapshot& operator=(const MappedSnapshot&) = delete;
+
+    // False when the file is missing, truncated or not a version 2 snapshot.
+    bool valid() const { return m_base != nullptr; }
+
+    const SnapshotHeader& header() const { return *reinterpret_cast<const SnapshotHeader*>(m_base); }
+
+    std::span<const SnapshotBook> books() const { return section<SnapshotBook>(header().booksOffset, header().bookCount); }
+
+    std::span<const SnapshotLevel> levels(const SnapshotBook& book) const
+    {
+        return section<SnapshotLevel>(book.levelsOffset, std::uint64_t{book.bidLevels} + book.askLevels);
+    }
+
+    std::span<const OrderNode> nodes(const SnapshotBook& book) const { return section<OrderNode>(book.nodesOffset, book.carved); }
+
+    std::span<const IndexEntry> indexSlots() const { return section<IndexEntry>(header().indexOffset, header().indexSlots); }
+};
+
+// Loads a snapshot's books and index into books and index, which must have
+// the same number of books with the same ladder bands as when it was taken.
+// Every book and the index are reset first. Returns false, leaving them empty,
+// when the shapes differ.
+bool restoreSnapshot(const MappedSnapshot& snapshot, std::span<OrderBook> books, OrderIndex& index);
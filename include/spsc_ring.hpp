@@ -0,0 +1,78 @@
+#pragma once
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+
+inline constexpr std::size_t kCacheLine = 64;
+
+// Bounded single-producer single-consumer ring. Head and tail sit on their own
+// cache lines, and each side keeps a private copy of the other's index so the
+// shared line is only re-read when the ring looks full (producer) or empty
+// (consumer). Capacity is rounded up to a power of two.
+template<typename T>
+class SpscRing
+{
+    private:
+    std::unique_ptr<T[]> m_slots;
+    std::size_t m_mask;
+
+    alignas(kCacheLine) std::atomic<std::size_t> m_tail{0}; // next slot to write
+    std::size_t m_cachedHead{0};
+    alignas(kCacheLine) std::atomic<std::size_t> m_head{0}; // next slot to read
+    std::size_t m_cachedTail{0};
+
+    public:
+    explicit SpscRing(std::size_t capacity)
+    : m_slots(std::make_unique<T[]>(std::bit_ceil(capacity)))
+    , m_mask(std::bit_ceil(capacity) - 1)
+    {}
+
+    // Producer only. Returns false when the ring is full.
+    bool tryPush(const T& value)
+    {
+        const std::size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_cachedHead > m_mask)
+        {
+            m_cachedHead = m_head.load(std::memory_order_acquire);
+            if (tail - m_cachedHead > m_mask) return false;
+        }
+        m_slots[tail & m_mask] = value;
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only. Returns false when the ring is empty.
+    bool tryPop(T& out)
+    {
+        const std::size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_cachedTail)
+        {
+            m_cachedTail = m_tail.load(std::memory_order_acquire);
+            if (head == m_cachedTail) return false;
+        }
+        out = m_slots[head & m_mask];
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only. Pops up to max values into out and returns how many.
+    std::size_t popBatch(T* out, std::size_t max)
+    {
+        const std::size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_cachedTail) m_cachedTail = m_tail.load(std::memory_order_acquire);
+        std::size_t count = m_cachedTail - head;
+        if (count > max) count = max;
+        for (std::size_t i = 0; i < count; ++i) out[i] = m_slots[(head + i) & m_mask];
+        if (count != 0) m_head.store(head + count, std::memory_order_release);
+        return count;
+    }
+
+    // Approximate from any thread; exact from either end while the other is idle.
+    std::size_t size() const
+    {
+        return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire);
+    }
+
+    std::size_t capacity() const { return m_mask + 1; }
+};
@@ -0,0 +1,91 @@
+#pragma once
+#include "order.hpp"
+#include "spsc_ring.hpp"
+#include "trade.hpp"
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <thread>
+#include <type_traits>
+
+// Best bid and offer of one book plus its most recent trade, as seen at the
+// end of a command. A side with no orders has price, qty and orders all 0,
+// and lastQty is 0 until the book has traded.
+struct TopOfBook
+{
+    Price bidPrice{};
+    Quantity bidQty{};
+    std::uint32_t bidOrders{};
+    Price askPrice{};
+    Quantity askQty{};
+    std::uint32_t askOrders{};
+    Price lastPrice{};
+    Quantity lastQty{};
+    TradeID lastTradeID{};
+
+    bool operator==(const TopOfBook&) const = default;
+};
+
+static_assert(sizeof(TopOfBook) == 40 && std::is_trivially_copyable_v<TopOfBook>);
+
+// A TopOfBook published by one writer thread to any number of readers under a
+// seqlock, on a cache line of its own. The writer bumps the sequence to odd,
+// stores the record, and bumps it to even; a reader copies the record between
+// two loads of the sequence and keeps the copy only if both are the same even
+// value. The record is held as relaxed atomic words, so the copy is not a data
+// race even when it is discarded.
+//
+// The writer never waits for readers: publish() is a fixed handful of stores,
+// and is skipped when nothing changed so readers' cached lines stay valid.
+// tryRead() is wait-free; read() retries only while a publish overlaps it.
+class alignas(kCacheLine) TopOfBookCell
+{
+    private:
+    static constexpr std::size_t kWords = sizeof(TopOfBook) / sizeof(std::uint64_t);
+
+    std::atomic<std::uint64_t> m_sequence{0};
+    std::array<std::atomic<std::uint64_t>, kWords> m_words{};
+
+    public:
+    // Writer only.
+    void publish(const TopOfBook& top)
+    {
+        const auto words = std::bit_cast<std::array<std::uint64_t, kWords>>(top);
+        bool changed{false};
+        for (std::size_t i = 0; i < kWords; ++i) changed |= m_words[i].load(std::memory_order_relaxed) != words[i];
+        if (!changed) return;
+        const std::uint64_t sequence = m_sequence.load(std::memory_order_relaxed);
+        m_sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (std::size_t i = 0; i < kWords; ++i) m_words[i].store(words[i], std::memory_order_relaxed);
+        m_sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    // Any thread. False, leaving out untouched, when a publish was in flight.
+    bool tryRead(TopOfBook& out) const
+    {
+        const std::uint64_t before = m_sequence.load(std::memory_order_acquire);
+        if (before & 1) return false;
+        std::array<std::uint64_t, kWords> words;
+        for (std::size_t i = 0; i < kWords; ++i) words[i] = m_words[i].load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (m_sequence.load(std::memory_order_relaxed) != before) return false;
+        out = std::bit_cast<TopOfBook>(words);
+        return true;
+    }
+
+    // Any thread.
+    TopOfBook read() const
+    {
+        TopOfBook top;
+        while (!tryRead(top)) std::this_thread::yield();
+        return top;
+    }
+
+    // Any thread. How many times the record has changed; a reader polling for
+    // news compares this with the value it last saw.
+    std::uint64_t version() const { return m_sequence.load(std::memory_order_acquire) / 2; }
+};
+
+static_assert(sizeof(TopOfBookCell) == kCacheLine);
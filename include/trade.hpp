@@ -1,44 +1,107 @@
 #pragma once
 #include "order.hpp"
+#include "trade_clock.hpp"
+#include <cstddef>
 #include <cstdint>
+#include <memory_resource>
+#include <span>
 #include <vector>
-#include <chrono> 
 
 using TradeID = std::uint64_t; 
-using Clock = std::chrono::high_resolution_clock;
-using Timestamp = Clock::time_point;
+// Raw reading from the engine's TradeClock; TradeClock::toNanos converts it
+// given the source it came from.
+using Timestamp = std::uint64_t;
+// One execution, 40 bytes.
 struct Trade
 {
-    size_t m_symbol{};
     TradeID m_TradeID{};
+    Timestamp m_Time{};
+    std::uint32_t m_symbol{};
     Price m_Price{};
     Quantity m_Qty{};
     OrderID m_AggressorOrderID{};
     OrderID m_RestingOrderID{};
     OrderSide m_AggressorSide{};
-    Timestamp m_Time{};
+    TimestampSource m_TimeSource{};   // what m_Time was read from
+
+    Trade() = default;
 
-    Trade(size_t symbol, TradeID id, Price price, Quantity quantity, OrderID aggressorOrderID, OrderID restingOrderID, OrderSide aggressorside)
-    : m_symbol{symbol}
-    , m_TradeID{id}
+    Trade(size_t symbol, TradeID id, Price price, Quantity quantity, OrderID aggressorOrderID, OrderID restingOrderID, OrderSide aggressorside, Timestamp time,
+          TimestampSource timeSource = TimestampSource::Counter)
+    : m_TradeID{id}
+    , m_Time{time}
+    , m_symbol{static_cast<std::uint32_t>(symbol)}
     , m_Price{price}
     , m_Qty{quantity}
     , m_AggressorOrderID{aggressorOrderID}
     , m_RestingOrderID{restingOrderID}
     , m_AggressorSide{aggressorside}
-    , m_Time{Clock::now()}
+    , m_TimeSource{timeSource}
     {};
 
 };
+
+static_assert(sizeof(Trade) == 40);
+
+// What a read() by sequence returned: count trades were copied, the caller's
+// next read should start at next, and overwritten trades between the requested
+// sequence and the oldest one still held were lost to the ring wrapping.
+struct TradeRead
+{
+    std::size_t count{};
+    std::uint64_t next{};
+    std::uint64_t overwritten{};
+};
+
+// Bounded ring of the most recent trades. Capacity is a power of two fixed at
+// construction, so record() is a single store into preallocated memory however
+// many trades have printed. Every trade gets the next sequence number, starting
+// at 0; once the ring wraps, the oldest trades are overwritten and a reader that
+// fell more than capacity() behind is told how many it missed.
 class TradeLog 
 {
+    public:
+    static constexpr std::size_t kDefaultCapacity = std::size_t{1} << 16;
+
     private:
-    std::vector<Trade> tradelog;
+    std::pmr::vector<Trade> tradelog;
+    std::size_t m_mask{};
+    std::uint64_t m_next{};
 
     public:
+    // capacity is rounded up to a power of two.
+    explicit TradeLog(std::size_t capacity = kDefaultCapacity,
+                      std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    explicit TradeLog(std::pmr::memory_resource* resource)
+    : TradeLog(kDefaultCapacity, resource)
+    {}
+
     void record(const Trade& trade); 
 
-    void printTrade(std::size_t index) const;
+    // Forgets every trade and restarts sequences at 0; the ring is kept.
+    void clear();
+
+    std::size_t capacity() const { return tradelog.size(); }
+
+    // Sequence the next trade will get, i.e. how many have ever been recorded.
+    std::uint64_t nextSequence() const { return m_next; }
+
+    // Oldest sequence still in the ring.
+    std::uint64_t oldestSequence() const { return m_next > capacity() ? m_next - capacity() : 0; }
+
+    // Trades a reader positioned at sequence has yet to see.
+    std::uint64_t lag(std::uint64_t sequence) const { return m_next - sequence; }
+
+    // The trade with this sequence, or nullptr once overwritten or not yet recorded.
+    const Trade* find(std::uint64_t sequence) const;
+
+    // Copies trades from sequence onwards into out, oldest first.
+    TradeRead read(std::uint64_t sequence, std::span<Trade> out) const;
+
+    // index is a sequence number; clock must be the one that stamped the trade.
+    void printTrade(std::size_t index, const TradeClock& clock) const;
         
+    // Total recorded, including trades since overwritten.
     std::size_t getTradeLogSize() const;
 };
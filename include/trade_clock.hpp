@@ -0,0 +1,56 @@
+#pragma once
+#include <cstdint>
+
+// Where trade timestamps come from.
+//   Counter: the raw cycle counter (rdtsc / cntvct_el0), a few cycles to read;
+//            ticks become nanoseconds only when a stamp is converted.
+//   System:  std::chrono::system_clock, nanoseconds since the epoch.
+//   Virtual: whatever the caller last set, for simulations replaying their own
+//            time line.
+enum class TimestampSource : std::uint8_t
+{
+    Counter,
+    System,
+    Virtual,
+};
+
+// Produces raw stamps for trades and turns them into nanoseconds since the
+// epoch on demand. The engine reads it at most once per command, when the
+// first fill happens, and every fill of that command shares the stamp. A stamp
+// is converted with the source it was taken from, which trades carry, so
+// switching sources later does not change how earlier stamps read.
+//
+// Constructing the first clock in a process calibrates the counter (see
+// calibrateCounter()), so build engines before the matching threads start.
+class TradeClock
+{
+    private:
+    TimestampSource m_source{TimestampSource::Counter};
+    std::uint64_t m_virtualNs{};
+    // One counter reading paired with the wall clock, taken at construction
+    // and kept for life (copies share it), anchors counter stamps to the
+    // epoch.
+    std::uint64_t m_anchorTicks{};
+    std::int64_t m_anchorNs{};
+
+    public:
+    TradeClock();
+
+    explicit TradeClock(TimestampSource source);
+
+    TimestampSource source() const { return m_source; }
+
+    void setSource(TimestampSource source);
+
+    // Virtual source only.
+    void setVirtualTime(std::uint64_t nanos) { m_virtualNs = nanos; }
+
+    void advance(std::uint64_t nanos) { m_virtualNs += nanos; }
+
+    std::uint64_t stamp() const;
+
+    // Nanoseconds since the epoch for a stamp taken from this clock, or a copy
+    // of it, while source was selected. Counter stamps are scaled here by the
+    // rate the constructor calibrated, so converting never waits.
+    std::int64_t toNanos(std::uint64_t stamp, TimestampSource source) const;
+};
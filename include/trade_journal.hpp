@@ -0,0 +1,53 @@
+#pragma once
+#include "async_journal.hpp"
+#include "trade.hpp"
+#include "trade_clock.hpp"
+#include <cstdint>
+
+// Trade journal file format, version 1:
+//
+//   header, 16 bytes:  char magic[8] = "OBTRDJNL"
+//                      u32  version  = 1
+//                      u32  recordSize = sizeof(JournalRecord) = 40
+//   records, back to back, one per trade in the order the engine printed them.
+struct JournalRecord
+{
+    std::uint64_t tradeID{};
+    std::int64_t timeNs{};          // nanoseconds since the epoch
+    std::uint32_t symbol{};
+    Price price{};
+    Quantity qty{};
+    OrderID aggressorID{};
+    OrderID restingID{};
+    std::uint8_t aggressorSide{};   // 0 = Bid, 1 = Ask
+    std::uint8_t reserved[3]{};
+};
+
+static_assert(sizeof(JournalRecord) == 40);
+
+// The ring carries the 40-byte Trade itself; its counter stamp is converted
+// to nanoseconds on the writer thread with a copy of the engine's clock.
+struct TradeCodec
+{
+    using Entry = Trade;
+    using Record = JournalRecord;
+
+    static constexpr JournalHeader kHeader{{'O', 'B', 'T', 'R', 'D', 'J', 'N', 'L'}, 1, sizeof(JournalRecord)};
+
+    TradeClock clock;
+
+    TradeCodec(const TradeClock& engineClock)
+    : clock{engineClock}
+    {}
+
+    JournalRecord encode(const Trade& trade, std::uint64_t sequence) const;
+};
+
+// Persists trades off the matching thread. Plug it into an engine through its
+// sink (engine.sink.journal = &journal) or call append() directly.
+using TradeJournal = AsyncJournal<TradeCodec>;
+
+using JournalReader = BasicJournalReader<TradeCodec>;
+
+extern template class AsyncJournal<TradeCodec>;
+extern template class BasicJournalReader<TradeCodec>;
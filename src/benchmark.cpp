@@ -1,13 +1,20 @@
 #include "matching_engine.hpp"
+#include "sharded_engine.hpp"
 #include "timersetup.hpp"
 #include <algorithm>
+#include <chrono>
 #include <cstdint>
 #include <cstdio>
 #include <random>
+#include <span>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
 constexpr size_t kWorkloadSize = 500'000;
 constexpr size_t kRuns = 10;
+// generateprice() never leaves this band, so ladder books accept the whole workload.
+constexpr PriceBand kLadderBand{1, 300};
 
 MatchingEngine engine(200);
 
@@ -87,14 +94,14 @@ Operation generatelimitorder(){
 std::uniform_int_distribution<int> type (0, 2);
 std::uniform_int_distribution<int> side (0, 1);
 Operation::Type ordertype {type(gen)};
-OrderSide orderside {side(gen)};
+OrderSide orderside {static_cast<std::uint8_t>(side(gen))};
 return {ordertype, generatesymbol(), generateprice(), orderside, generatequantity(),OrderIDGenerator::next()};
 }
 
 Operation generatemarketorder(){
 std::uniform_int_distribution<int> side (0, 1);
 Operation::Type ordertype {Operation::Type::Market};
-OrderSide orderside {side(gen)};
+OrderSide orderside {static_cast<std::uint8_t>(side(gen))};
 return {ordertype, generatesymbol(), -1, orderside, generatequantity(), OrderIDGenerator::next()};
 }
 
@@ -201,21 +208,37 @@ LatencyMetrics benchmark(const std::vector<Operation>& workload,
 }
 
 
-int main(){
-
-  // stdout is block-buffered when not a TTY (e.g. over ssh); unbuffer so
-  // results print live and survive an early kill.
-  std::setvbuf(stdout, nullptr, _IONBF, 0);
+// Memory per resting order at a known population: kFootprintOrders GTC bids
+// rested across the books of a fresh engine. The allocated figure counts what
+// the pools and index hold for them, free pool slots and the index's
+// load-factor headroom included.
+constexpr size_t kFootprintOrders = 200'000;
 
-  std::printf("timer overhead: %llu ticks | counter rate: %.3f ticks/ns\n",
-              static_cast<unsigned long long>(timerOverhead), ticksPerNs());
+void printRestingFootprint(){
+  MatchingEngine fresh(200);
+  for(size_t i {}; i < kFootprintOrders; ++i){
+    fresh.submitLimitOrder(static_cast<SymbolID>(i % 200), OrderSide::Bid, 1,
+                           OrderIDGenerator::next(), static_cast<Price>(i % 300 + 1));
+  }
+  size_t allocated = fresh.orderIndex.capacity() * sizeof(IndexEntry);
+  for(const auto& book: fresh.book) allocated += book.m_pool.capacity() * sizeof(OrderNode);
+  std::printf("[footprint] %zu resting orders: %zu bytes record + index, %.1f allocated per order\n",
+              fresh.orderIndex.size(), sizeof(OrderNode) + sizeof(IndexEntry),
+              static_cast<double>(allocated) / static_cast<double>(fresh.orderIndex.size()));
+}
 
+// Runs the workload kRuns times against a 200-symbol engine built once by
+// makeEngine and reset() between runs, and prints the averaged percentiles
+// under label.
+template<typename MakeEngine>
+void runMode(const char* label, MakeEngine makeEngine){
   LatencyMetrics avg{};
   std::vector<uint64_t> cycles;
   cycles.reserve(kWorkloadSize);
 
+  engine = makeEngine();
   for(size_t run {}; run < kRuns; ++run){
-    engine = MatchingEngine(200);
+    engine.reset();
     std::vector<Operation> workload {buildworkload()};
 
     const LatencyMetrics metrics = benchmark(workload, cycles);
@@ -231,10 +254,116 @@ int main(){
   std::fprintf(stderr, "\n");
 
   const auto runs = static_cast<double>(kRuns);
-  std::printf("averaged over %zu runs of %zu ops:\n", kRuns, kWorkloadSize);
+  std::printf("[%s] averaged over %zu runs of %zu ops:\n", label, kRuns, kWorkloadSize);
   std::printf("  P90    latency: %10.1f ns\n", avg.p90Ns  / runs);
   std::printf("  P99    latency: %10.1f ns\n", avg.p99Ns  / runs);
   std::printf("  P99.9  latency: %10.1f ns\n", avg.p999Ns / runs);
   std::printf("  cycles per op : %10.1f\n",    avg.cyclesPerOp / runs);
+}
+
+
+// The sharded engine routes modifies by symbol, so cancels/reduces pick up the
+// ticker of the order they target (ticker 0 if it never existed).
+Command toCommand(const Operation& op,
+                  const std::unordered_map<OrderID, SymbolID>& tickerOf){
+  const auto owner = [&]{
+    const auto it = tickerOf.find(op.oid);
+    return it == tickerOf.end() ? SymbolID{0} : it->second;
+  };
+  switch(op.type){
+  case Operation::Type::LimitFOK:
+    return Command::limit(op.ticker, op.side, op.qty, op.oid, op.price, LimitType::FOK);
+  case Operation::Type::LimitIOC:
+    return Command::limit(op.ticker, op.side, op.qty, op.oid, op.price, LimitType::IOC);
+  case Operation::Type::LimitGTC:
+    return Command::limit(op.ticker, op.side, op.qty, op.oid, op.price, LimitType::GTC);
+  case Operation::Type::Market:
+    return Command::market(op.ticker, op.side, op.qty, op.oid);
+  case Operation::Type::Cancel:
+    return Command::cancel(op.oid, owner());
+  case Operation::Type::ReduceQTY:
+    return Command::reduce(op.oid, op.qty, owner());
+  }
+  return {};
+}
+
+// Same workload through processBatch in chunks of kBatchSize, timing each chunk;
+// reports amortised cycles per op to compare with the per-call API. makeEngine
+// may build any BasicMatchingEngine, so sinks can be compared.
+template<typename MakeEngine>
+void runBatchMode(const char* label, MakeEngine makeEngine){
+  constexpr size_t kBatchSize = 64;
+  const std::unordered_map<OrderID, SymbolID> noTickers;
+  std::vector<CommandResult> results(kBatchSize);
+  std::vector<Fill> fills(kBatchSize * 16);
+  double cyclesPerOp {};
+
+  auto batchEngine = makeEngine();
+  for(size_t run {}; run < kRuns; ++run){
+    batchEngine.reset();
+    const std::vector<Operation> workload {buildworkload()};
+    std::vector<Command> commands;
+    commands.reserve(workload.size());
+    for(const auto& op: workload) commands.push_back(toCommand(op, noTickers));
+
+    uint64_t totalCycles {};
+    for(size_t i {}; i < commands.size(); i += kBatchSize){
+      const size_t count = std::min(kBatchSize, commands.size() - i);
+      const uint64_t start = startClock();
+      batchEngine.processBatch(std::span<const Command>(commands).subspan(i, count), results, fills);
+      const uint64_t stop = stopClock();
+      totalCycles += calculateCycles(start, stop);
+    }
+    cyclesPerOp += static_cast<double>(totalCycles) / static_cast<double>(commands.size());
+  }
+  std::printf("[%s] batches of %zu: %10.1f cycles per op\n", label, kBatchSize,
+              cyclesPerOp / static_cast<double>(kRuns));
+}
+
+// Wall-clock throughput of the sharded engine for 1, 2, 4, ... shards up to the
+// core count: one router thread feeds the whole workload, then waits for every
+// shard to drain.
+void runSharded(){
+  const std::vector<Operation> workload {buildworkload()};
+  std::unordered_map<OrderID, SymbolID> tickerOf;
+  for(const auto& op: workload){
+    if(op.type != Operation::Type::Cancel && op.type != Operation::Type::ReduceQTY){
+      tickerOf.emplace(op.oid, op.ticker);
+    }
+  }
+  std::vector<Command> commands;
+  commands.reserve(workload.size());
+  for(const auto& op: workload) commands.push_back(toCommand(op, tickerOf));
+
+  const size_t cores = std::max(1u, std::thread::hardware_concurrency());
+  for(size_t shards {1}; shards <= cores; shards *= 2){
+    ShardedEngine sharded(200, shards, kLadderBand);
+    const auto start = std::chrono::steady_clock::now();
+    for(const auto& command: commands) sharded.submit(command);
+    sharded.flush();
+    const double seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::printf("[sharded x%zu] %10.2f Mops/s\n", shards,
+                static_cast<double>(commands.size()) / seconds / 1e6);
+  }
+}
+
+
+int main(){
+
+  // stdout is block-buffered when not a TTY (e.g. over ssh); unbuffer so
+  // results print live and survive an early kill.
+  std::setvbuf(stdout, nullptr, _IONBF, 0);
+
+  calibrateCounter();
+  std::printf("timer overhead: %llu ticks | counter rate: %.3f ticks/ns\n",
+              static_cast<unsigned long long>(timerOverhead), ticksPerNs());
+
+  runMode("map books", []{ return MatchingEngine(200); });
+  runMode("ladder books", []{ return MatchingEngine(200, kLadderBand); });
+  runBatchMode("ladder books", []{ return MatchingEngine(200, kLadderBand); });
+  runBatchMode("ladder books, no-op sink", []{ return BasicMatchingEngine<NullSink>(200, kLadderBand); });
+  runSharded();
+  printRestingFootprint();
 
 }
@@ -0,0 +1,187 @@
+#include "book_side.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+    namespace
+    {
+        std::size_t ladderTicks(PriceBand band)
+        {
+            if (!validBand(band)) throw std::invalid_argument("PriceBand must be positive with minPrice <= maxPrice");
+            return static_cast<std::size_t>(band.maxPrice - band.minPrice) + 1;
+        }
+    }
+
+    template<typename Compare>
+    BookSide<Compare>::BookSide(std::pmr::memory_resource* resource)
+    : m_levels(resource)
+    , m_ladder(resource)
+    {}
+
+    template<typename Compare>
+    BookSide<Compare>::BookSide(PriceBand band, std::pmr::memory_resource* resource)
+    : m_levels(resource)
+    , m_ladder(ladderTicks(band), resource)
+    , m_occupied(m_ladder.size(), resource)
+    , m_depth(m_ladder.size(), resource)
+    , m_minPrice{band.minPrice}
+    , m_isLadder{true}
+    {}
+
+    template<typename Compare>
+    bool BookSide<Compare>::inBand(Price price) const
+    {
+        if (!m_isLadder) return true;
+        return price >= m_minPrice && indexOf(price) < m_ladder.size();
+    }
+
+    template<typename Compare>
+    PriceLevel& BookSide<Compare>::levelFor(Price price)
+    {
+        if (!m_isLadder) return m_levels.try_emplace(price).first->second;
+        const std::size_t index = indexOf(price);
+        PriceLevel& level = m_ladder[index];
+        if (level.orders.empty())
+        {
+            ++m_ladderLevels;
+            m_occupied.set(index);
+            if (m_best == kNoLevel || Compare{}(price, priceAt(m_best))) m_best = index;
+        }
+        return level;
+    }
+
+    template<typename Compare>
+    PriceLevel* BookSide<Compare>::find(Price price)
+    {
+        if (!m_isLadder)
+        {
+            auto levelIT = m_levels.find(price);
+            return levelIT == m_levels.end() ? nullptr : &levelIT->second;
+        }
+        if (!inBand(price)) return nullptr;
+        PriceLevel& level = m_ladder[indexOf(price)];
+        return level.orders.empty() ? nullptr : &level;
+    }
+
+    template<typename Compare>
+    void BookSide<Compare>::addQuantity(PriceLevel& level, Price price, Quantity quantity)
+    {
+        level.levelQTY += quantity;
+        if (m_isLadder) m_depth.add(indexOf(price), quantity);
+    }
+
+    template<typename Compare>
+    void BookSide<Compare>::removeQuantity(PriceLevel& level, Price price, Quantity quantity)
+    {
+        level.levelQTY -= quantity;
+        if (m_isLadder) m_depth.subtract(indexOf(price), quantity);
+    }
+
+    // On a ladder this is one or two prefix sums; a std::map side walks levels
+    // from the best and stops as soon as volume is covered or limit is passed.
+    template<typename Compare>
+    bool BookSide<Compare>::hasDepth(Price limit, Quantity volume) const
+    {
+        if (!m_isLadder)
+        {
+            std::uint64_t resting{};
+            forEachLevel([&](Price price, const PriceLevel& level)
+            {
+                if (!noWorseThan(price, limit)) return false;
+                resting += level.levelQTY;
+                return resting < volume;
+            });
+            return resting >= volume;
+        }
+        const Price maxPrice = priceAt(m_ladder.size() - 1);
+        std::uint64_t resting;
+        if constexpr (kBetterIsHigher)
+        {
+            if (limit > maxPrice) resting = 0;
+            else if (limit <= m_minPrice) resting = m_depth.total();
+            else resting = m_depth.total() - m_depth.prefix(indexOf(limit) - 1);
+        }
+        else
+        {
+            if (limit < m_minPrice) resting = 0;
+            else if (limit >= maxPrice) resting = m_depth.total();
+            else resting = m_depth.prefix(indexOf(limit));
+        }
+        return resting >= volume;
+    }
+
+    template<typename Compare>
+    void BookSide<Compare>::erase(Price price)
+    {
+        if (!m_isLadder)
+        {
+            m_levels.erase(price);
+            return;
+        }
+        const std::size_t index = indexOf(price);
+        m_depth.subtract(index, m_ladder[index].levelQTY);
+        m_ladder[index].levelQTY = 0;
+        m_occupied.clear(index);
+        --m_ladderLevels;
+        if (index == m_best) m_best = nextWorse(index);
+    }
+
+    template<typename Compare>
+    void BookSide<Compare>::restoreLevel(Price price, OrderQueue orders, Quantity levelQTY)
+    {
+        PriceLevel& level = levelFor(price);
+        level.orders = orders;
+        addQuantity(level, price, levelQTY);
+    }
+
+    template<typename Compare>
+    std::size_t BookSide<Compare>::topLevels(std::span<Price> prices, std::span<Quantity> quantities) const
+    {
+        const std::size_t capacity = std::min(prices.size(), quantities.size());
+        std::size_t written{};
+        if (capacity == 0) return 0;
+        forEachLevel([&](Price price, const PriceLevel& level)
+        {
+            prices[written] = price;
+            quantities[written] = level.levelQTY;
+            return ++written < capacity;
+        });
+        return written;
+    }
+
+    template<typename Compare>
+    void BookSide<Compare>::eraseBest()
+    {
+        if (!m_isLadder)
+        {
+            m_levels.erase(m_levels.begin());
+            return;
+        }
+        m_depth.subtract(m_best, m_ladder[m_best].levelQTY);
+        m_ladder[m_best].levelQTY = 0;
+        m_occupied.clear(m_best);
+        --m_ladderLevels;
+        m_best = nextWorse(m_best);
+    }
+
+    template<typename Compare>
+    void BookSide<Compare>::clear()
+    {
+        if (!m_isLadder)
+        {
+            m_levels.clear();
+            return;
+        }
+        for (std::size_t i = m_best; i != kNoLevel;)
+        {
+            const std::size_t next = nextWorse(i);
+            m_depth.subtract(i, m_ladder[i].levelQTY);
+            m_ladder[i] = PriceLevel{};
+            m_occupied.clear(i);
+            i = next;
+        }
+        m_best = kNoLevel;
+        m_ladderLevels = 0;
+    }
+
+    template class BookSide<std::greater<Price>>;
+    template class BookSide<std::less<Price>>;
@@ -0,0 +1,34 @@
+#include "command_log.hpp"
+#include "async_journal_impl.hpp"
+
+    CommandRecord CommandCodec::encode(const Command& command, std::uint64_t sequence) const
+    {
+        CommandRecord record;
+        record.sequence = sequence;
+        record.type = static_cast<std::uint8_t>(command.type);
+        record.side = static_cast<std::uint8_t>(command.side);
+        record.limitType = static_cast<std::uint8_t>(command.limitType);
+        record.ticker = static_cast<std::uint32_t>(command.ticker);
+        record.id = command.id;
+        record.price = command.price;
+        record.qty = command.qty;
+        record.newID = command.newID;
+        return record;
+    }
+
+    Command CommandCodec::decode(const CommandRecord& record)
+    {
+        Command command;
+        command.type = static_cast<Command::Type>(record.type);
+        command.side = static_cast<OrderSide>(record.side);
+        command.limitType = static_cast<LimitType>(record.limitType);
+        command.ticker = record.ticker;
+        command.id = record.id;
+        command.price = record.price;
+        command.qty = record.qty;
+        command.newID = record.newID;
+        return command;
+    }
+
+    template class AsyncJournal<CommandCodec>;
+    template class BasicJournalReader<CommandCodec>;
@@ -0,0 +1,29 @@
+#include "cycle_counter.hpp"
+#include <chrono>
+#include <thread>
+
+    namespace
+    {
+    double measureTicksPerNs()
+    {
+#if defined(__aarch64__)
+        uint64_t freqHz;
+        __asm__ __volatile__("mrs %0, cntfrq_el0" : "=r"(freqHz));
+        return static_cast<double>(freqHz) / 1e9;
+#else
+        const auto t0 = std::chrono::steady_clock::now();
+        const uint64_t c0 = startClock();
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        const uint64_t c1 = stopClock();
+        const auto t1 = std::chrono::steady_clock::now();
+        const double elapsedNs = std::chrono::duration<double, std::nano>(t1 - t0).count();
+        return static_cast<double>(c1 - c0) / elapsedNs;
+#endif
+    }
+    }
+
+    double ticksPerNs()
+    {
+        static const double rate = measureTicksPerNs();
+        return rate;
+    }
@@ -0,0 +1,126 @@
+#include "depth_tracker.hpp"
+#include <algorithm>
+
+    namespace
+    {
+    template<class Side>
+    Quantity levelQuantity(Side& side, Price price)
+    {
+        const PriceLevel* level = side.find(price);
+        return level == nullptr ? 0 : level->levelQTY;
+    }
+    }
+
+    void DepthTracker::enable(std::size_t depth)
+    {
+        m_depth = depth;
+        m_enabled = true;
+        m_touched.reserve(64);
+        for (auto& window : m_window) window.reserve(depth);
+        m_scratch.reserve(depth);
+        m_out.reserve(std::max<std::size_t>(2 * depth, 64));
+        clear();
+    }
+
+    void DepthTracker::disable()
+    {
+        m_enabled = false;
+        clear();
+    }
+
+    void DepthTracker::clear()
+    {
+        m_touched.clear();
+        for (auto& window : m_window) window.clear();
+        m_dirty[0] = m_dirty[1] = m_depth > 0;
+    }
+
+    template<class Bids, class Asks>
+    void DepthTracker::touchAll(const Bids& bids, const Asks& asks)
+    {
+        if (!m_enabled) return;
+        if (m_depth > 0)
+        {
+            m_dirty[0] = m_dirty[1] = true;
+            return;
+        }
+        bids.forEachLevel([&](Price price, const PriceLevel&)
+        {
+            m_touched.push_back(DepthUpdate{OrderSide::Bid, price, 0});
+            return true;
+        });
+        asks.forEachLevel([&](Price price, const PriceLevel&)
+        {
+            m_touched.push_back(DepthUpdate{OrderSide::Ask, price, 0});
+            return true;
+        });
+    }
+
+    // Both lists are best first, so one merge pass finds the levels that left
+    // the window, the ones that entered it and the ones whose quantity moved.
+    template<OrderSide S, class Side>
+    void DepthTracker::diffWindow(Side& side)
+    {
+        auto& published = m_window[indexOf(S)];
+        m_scratch.clear();
+        side.forEachLevel([&](Price price, const PriceLevel& level)
+        {
+            m_scratch.push_back(DepthUpdate{S, price, level.levelQTY});
+            return m_scratch.size() < m_depth;
+        });
+        std::size_t before{};
+        std::size_t after{};
+        while (before < published.size() || after < m_scratch.size())
+        {
+            if (after == m_scratch.size()
+                || (before < published.size() && published[before].price != m_scratch[after].price
+                    && Side::noWorseThan(published[before].price, m_scratch[after].price)))
+            {
+                m_out.push_back(DepthUpdate{S, published[before++].price, 0});
+            }
+            else if (before == published.size() || published[before].price != m_scratch[after].price)
+            {
+                m_out.push_back(m_scratch[after++]);
+            }
+            else
+            {
+                if (published[before].qty != m_scratch[after].qty) m_out.push_back(m_scratch[after]);
+                ++before;
+                ++after;
+            }
+        }
+        published.swap(m_scratch);
+        m_dirty[indexOf(S)] = false;
+    }
+
+    template<class Bids, class Asks>
+    std::span<const DepthUpdate> DepthTracker::collect(Bids& bids, Asks& asks)
+    {
+        m_out.clear();
+        if (!m_enabled) return {};
+        if (m_depth == 0)
+        {
+            // Sorting brings repeated touches of a level together, so each
+            // level is read and published once.
+            std::sort(m_touched.begin(), m_touched.end(), [](const DepthUpdate& lhs, const DepthUpdate& rhs)
+            {
+                if (lhs.side != rhs.side) return lhs.side == OrderSide::Bid;
+                return lhs.side == OrderSide::Bid ? lhs.price > rhs.price : lhs.price < rhs.price;
+            });
+            for (const DepthUpdate& touched : m_touched)
+            {
+                if (!m_out.empty() && m_out.back().side == touched.side && m_out.back().price == touched.price) continue;
+                const Quantity qty = touched.side == OrderSide::Bid ? levelQuantity(bids, touched.price)
+                                                                    : levelQuantity(asks, touched.price);
+                m_out.push_back(DepthUpdate{touched.side, touched.price, qty});
+            }
+            m_touched.clear();
+            return m_out;
+        }
+        if (m_dirty[0]) diffWindow<OrderSide::Bid>(bids);
+        if (m_dirty[1]) diffWindow<OrderSide::Ask>(asks);
+        return m_out;
+    }
+
+    template std::span<const DepthUpdate> DepthTracker::collect(BookSide<std::greater<Price>>&, BookSide<std::less<Price>>&);
+    template void DepthTracker::touchAll(const BookSide<std::greater<Price>>&, const BookSide<std::less<Price>>&);
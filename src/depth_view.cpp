@@ -0,0 +1,132 @@
+#include "depth_view.hpp"
+#include "cycle_counter.hpp"
+#include <utility>
+
+    // One published image. Cache-line aligned so the reader count of one
+    // buffer does not share a line with the other's.
+    struct alignas(kCacheLine) DepthView::Buffer
+    {
+        mutable std::atomic<std::uint32_t> readers{0};   // views pinning this image
+        std::uint64_t epoch{};
+        std::size_t bids{};
+        std::size_t asks{};
+        std::pmr::vector<Price> bidPrices;
+        std::pmr::vector<Quantity> bidQuantities;
+        std::pmr::vector<Price> askPrices;
+        std::pmr::vector<Quantity> askQuantities;
+
+        Buffer(std::size_t levelHint, std::pmr::memory_resource* resource)
+        : bidPrices(levelHint, resource)
+        , bidQuantities(levelHint, resource)
+        , askPrices(levelHint, resource)
+        , askQuantities(levelHint, resource)
+        {}
+    };
+
+    DepthView::DepthView(DepthView&& other) noexcept
+    : m_buffer{std::exchange(other.m_buffer, nullptr)}
+    {}
+
+    DepthView& DepthView::operator=(DepthView&& other) noexcept
+    {
+        if (this != &other)
+        {
+            if (m_buffer != nullptr) m_buffer->readers.fetch_sub(1, std::memory_order_release);
+            m_buffer = std::exchange(other.m_buffer, nullptr);
+        }
+        return *this;
+    }
+
+    DepthView::~DepthView()
+    {
+        if (m_buffer != nullptr) m_buffer->readers.fetch_sub(1, std::memory_order_release);
+    }
+
+    std::uint64_t DepthView::epoch() const { return m_buffer->epoch; }
+
+    std::span<const Price> DepthView::bidPrices() const { return {m_buffer->bidPrices.data(), m_buffer->bids}; }
+
+    std::span<const Quantity> DepthView::bidQuantities() const { return {m_buffer->bidQuantities.data(), m_buffer->bids}; }
+
+    std::span<const Price> DepthView::askPrices() const { return {m_buffer->askPrices.data(), m_buffer->asks}; }
+
+    std::span<const Quantity> DepthView::askQuantities() const { return {m_buffer->askQuantities.data(), m_buffer->asks}; }
+
+    PublishedDepth::PublishedDepth(DepthViewCadence cadence, std::size_t levelHint, std::pmr::memory_resource* resource)
+    : m_resource{resource}
+    , m_cadence{cadence}
+    {
+        std::pmr::polymorphic_allocator<DepthView::Buffer> allocator(m_resource);
+        for (auto& buffer : m_buffers) buffer = allocator.new_object<DepthView::Buffer>(levelHint, m_resource);
+        if (cadence.interval.count() > 0)
+        {
+            const auto nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(cadence.interval).count();
+            m_intervalTicks = static_cast<std::uint64_t>(static_cast<double>(nanos) * ticksPerNs());
+            m_lastRefresh = readCounter();
+        }
+    }
+
+    PublishedDepth::~PublishedDepth()
+    {
+        std::pmr::polymorphic_allocator<DepthView::Buffer> allocator(m_resource);
+        for (auto* buffer : m_buffers) allocator.delete_object(buffer);
+    }
+
+    bool PublishedDepth::due()
+    {
+        ++m_sinceRefresh;
+        if (m_retry) return true;
+        if (m_cadence.commands != 0 && m_sinceRefresh >= m_cadence.commands) return true;
+        return m_intervalTicks != 0 && readCounter() - m_lastRefresh >= m_intervalTicks;
+    }
+
+    // The writer is the only thread that moves m_current, so it knows which
+    // buffer is idle. Checking the idle buffer's reader count and a reader
+    // pinning it are both sequentially consistent, and a reader re-reads
+    // m_current after pinning: either the writer sees the pin and skips, or
+    // the reader sees the buffer is no longer current and lets go.
+    template<class Bids, class Asks>
+    bool PublishedDepth::refresh(const Bids& bids, const Asks& asks)
+    {
+        const std::uint32_t idle = 1 - m_current.load(std::memory_order_relaxed);
+        DepthView::Buffer& buffer = *m_buffers[idle];
+        if (buffer.readers.load() != 0)
+        {
+            m_skipped.fetch_add(1, std::memory_order_relaxed);
+            m_retry = true;
+            return false;
+        }
+        auto fill = [](const auto& side, auto& prices, auto& quantities)
+        {
+            if (prices.size() < side.levelCount())
+            {
+                prices.resize(side.levelCount());
+                quantities.resize(side.levelCount());
+            }
+            return side.topLevels(prices, quantities);
+        };
+        buffer.bids = fill(bids, buffer.bidPrices, buffer.bidQuantities);
+        buffer.asks = fill(asks, buffer.askPrices, buffer.askQuantities);
+        const std::uint64_t epoch = m_epoch.load(std::memory_order_relaxed) + 1;
+        buffer.epoch = epoch;
+        m_current.store(idle);
+        m_epoch.store(epoch, std::memory_order_release);
+        m_sinceRefresh = 0;
+        m_retry = false;
+        if (m_intervalTicks != 0) m_lastRefresh = readCounter();
+        return true;
+    }
+
+    DepthView PublishedDepth::acquire() const
+    {
+        while (true)
+        {
+            const std::uint32_t current = m_current.load();
+            DepthView::Buffer* buffer = m_buffers[current];
+            buffer->readers.fetch_add(1);
+            if (m_current.load() == current) return DepthView(buffer);
+            buffer->readers.fetch_sub(1, std::memory_order_release);
+        }
+    }
+
+    template bool PublishedDepth::refresh(const BookSide<std::greater<Price>>&, const BookSide<std::less<Price>>&);
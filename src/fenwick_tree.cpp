@@ -0,0 +1,24 @@
+#include "fenwick_tree.hpp"
+
+    FenwickTree::FenwickTree(std::size_t size, std::pmr::memory_resource* resource)
+    : m_tree(size + 1, resource)
+    {}
+
+    void FenwickTree::add(std::size_t index, std::uint64_t amount)
+    {
+        m_total += amount;
+        for (std::size_t i = index + 1; i < m_tree.size(); i += i & (~i + 1)) m_tree[i] += amount;
+    }
+
+    void FenwickTree::subtract(std::size_t index, std::uint64_t amount)
+    {
+        m_total -= amount;
+        for (std::size_t i = index + 1; i < m_tree.size(); i += i & (~i + 1)) m_tree[i] -= amount;
+    }
+
+    std::uint64_t FenwickTree::prefix(std::size_t index) const
+    {
+        std::uint64_t sum{};
+        for (std::size_t i = index + 1; i > 0; i &= i - 1) sum += m_tree[i];
+        return sum;
+    }
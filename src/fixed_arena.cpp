@@ -0,0 +1,49 @@
+#include "fixed_arena.hpp"
+#include <new>
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+    namespace
+    {
+    constexpr std::size_t kHugePage = std::size_t{2} << 20;
+    }
+
+    // Every page is faulted in here, so the first order to touch one does not
+    // take the fault on the matching path.
+    FixedArena::Block FixedArena::reserve(std::size_t bytes, bool hugePages)
+    {
+#if defined(__linux__)
+        const std::size_t rounded = (bytes + kHugePage - 1) / kHugePage * kHugePage;
+        if (hugePages)
+        {
+            void* base = mmap(nullptr, rounded, PROT_READ | PROT_WRITE,
+                              MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_POPULATE, -1, 0);
+            if (base != MAP_FAILED) return Block{base, rounded, true};
+        }
+        void* base = mmap(nullptr, rounded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (base == MAP_FAILED) throw std::bad_alloc{};
+        // Hint before the first touch so the kernel can fault in 2 MB pages.
+        if (hugePages) madvise(base, rounded, MADV_HUGEPAGE);
+        for (std::size_t offset = 0; offset < rounded; offset += 4096) static_cast<volatile char*>(base)[offset] = 0;
+        return Block{base, rounded, false};
+#else
+        (void)hugePages;
+        return Block{::operator new(bytes), bytes, false};
+#endif
+    }
+
+    FixedArena::FixedArena(std::size_t bytes, bool hugePages)
+    : m_block{reserve(bytes, hugePages)}
+    , m_resource{m_block.base, m_block.bytes, std::pmr::null_memory_resource()}
+    {}
+
+    FixedArena::~FixedArena()
+    {
+        m_resource.release();
+#if defined(__linux__)
+        munmap(m_block.base, m_block.bytes);
+#else
+        ::operator delete(m_block.base);
+#endif
+    }
@@ -0,0 +1,76 @@
+#include "journal_file.hpp"
+#include <cerrno>
+#include <cstring>
+#include <system_error>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+    namespace
+    {
+    [[noreturn]] void fail(int fd, const std::string& what)
+    {
+        const int error = errno;
+        if (fd >= 0) ::close(fd);
+        throw std::system_error(error, std::generic_category(), what);
+    }
+    }
+
+    bool operator==(const JournalHeader& lhs, const JournalHeader& rhs)
+    {
+        return std::memcmp(&lhs, &rhs, sizeof(JournalHeader)) == 0;
+    }
+
+    JournalFile::JournalFile(const std::string& path, const JournalHeader& header)
+    {
+        const int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        if (fd < 0) fail(fd, "open journal " + path);
+        struct stat info{};
+        if (::fstat(fd, &info) != 0) fail(fd, "stat journal " + path);
+        m_fd = fd;
+        if (info.st_size == 0)
+        {
+            if (!append(&header, sizeof(header))) fail(fd, "write journal header " + path);
+            return;
+        }
+        JournalHeader found{};
+        if (::pread(fd, &found, sizeof(found), 0) != static_cast<ssize_t>(sizeof(found)) || !(found == header))
+        {
+            errno = EINVAL;
+            fail(fd, "not a journal of the expected kind: " + path);
+        }
+        m_records = (static_cast<std::uint64_t>(info.st_size) - sizeof(JournalHeader)) / header.recordSize;
+        const auto whole = static_cast<off_t>(sizeof(JournalHeader) + m_records * header.recordSize);
+        if (whole != info.st_size && ::ftruncate(fd, whole) != 0) fail(fd, "truncate journal " + path);
+    }
+
+    JournalFile::~JournalFile()
+    {
+        ::close(m_fd);
+    }
+
+    bool JournalFile::append(const void* data, std::size_t bytes)
+    {
+        const char* next = static_cast<const char*>(data);
+        while (bytes > 0)
+        {
+            const ssize_t done = ::write(m_fd, next, bytes);
+            if (done < 0)
+            {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            next += done;
+            bytes -= static_cast<std::size_t>(done);
+        }
+        return true;
+    }
+
+    void JournalFile::sync()
+    {
+#if defined(__linux__)
+        ::fdatasync(m_fd);
+#else
+        ::fsync(m_fd);
+#endif
+    }
@@ -0,0 +1,100 @@
+#include "level_bitmap.hpp"
+
+    LevelBitmap::LevelBitmap(std::size_t size, std::pmr::memory_resource* resource)
+    : m_tiers(resource)
+    {
+        std::size_t words = (size + 63) / 64;
+        m_tiers.emplace_back(words);
+        while (words > 1)
+        {
+            words = (words + 63) / 64;
+            m_tiers.emplace_back(words);
+        }
+    }
+
+    void LevelBitmap::set(std::size_t index)
+    {
+        for (auto& tier : m_tiers)
+        {
+            std::uint64_t& word = tier[index >> 6];
+            const bool wasEmpty = word == 0;
+            word |= std::uint64_t{1} << (index & 63);
+            if (!wasEmpty) return;
+            index >>= 6;
+        }
+    }
+
+    void LevelBitmap::clear(std::size_t index)
+    {
+        for (auto& tier : m_tiers)
+        {
+            std::uint64_t& word = tier[index >> 6];
+            word &= ~(std::uint64_t{1} << (index & 63));
+            if (word != 0) return;
+            index >>= 6;
+        }
+    }
+
+    bool LevelBitmap::test(std::size_t index) const
+    {
+        return (m_tiers[0][index >> 6] >> (index & 63)) & 1;
+    }
+
+    // Climb while the remainder of the current word is empty, then descend along
+    // the lowest set bit of each tier below.
+    std::size_t LevelBitmap::nextSet(std::size_t from) const
+    {
+        std::size_t tier = 0;
+        std::size_t pos = from;
+        while (true)
+        {
+            if (tier == m_tiers.size()) return npos;
+            const std::size_t word = pos >> 6;
+            if (word >= m_tiers[tier].size()) return npos;
+            const std::uint64_t bits = m_tiers[tier][word] & (~std::uint64_t{0} << (pos & 63));
+            if (bits != 0)
+            {
+                pos = (word << 6) | lowestBit(bits);
+                break;
+            }
+            pos = word + 1;
+            ++tier;
+        }
+        while (tier > 0)
+        {
+            --tier;
+            pos = (pos << 6) | lowestBit(m_tiers[tier][pos]);
+        }
+        return pos;
+    }
+
+    std::size_t LevelBitmap::prevSet(std::size_t from) const
+    {
+        if (m_tiers.empty()) return npos;
+        std::size_t tier = 0;
+        std::size_t pos = from;
+        if ((pos >> 6) >= m_tiers[0].size()) pos = m_tiers[0].size() * 64 - 1;
+        while (true)
+        {
+            if (tier == m_tiers.size()) return npos;
+            const std::size_t word = pos >> 6;
+            const std::size_t bit = pos & 63;
+            const std::uint64_t mask =
+                bit == 63 ? ~std::uint64_t{0} : (std::uint64_t{1} << (bit + 1)) - 1;
+            const std::uint64_t bits = m_tiers[tier][word] & mask;
+            if (bits != 0)
+            {
+                pos = (word << 6) | highestBit(bits);
+                break;
+            }
+            if (word == 0) return npos;
+            pos = word - 1;
+            ++tier;
+        }
+        while (tier > 0)
+        {
+            --tier;
+            pos = (pos << 6) | highestBit(m_tiers[tier][pos]);
+        }
+        return pos;
+    }
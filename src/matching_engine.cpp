@@ -1,199 +1,34 @@
-#include "matching_engine.hpp"
-#include "order.hpp"
-  
-    MatchingEngine::MatchingEngine(size_t numberofsymbols)
-    {book.resize(numberofsymbols);}
-
-    MatchingEngine::MatchingEngine()
-    {
-    book.resize(1);
-    }
-    void MatchingEngine::submitLimitOrder(SymbolID ticker, OrderSide orderSide, Quantity quantity, OrderID orderID, Price price, LimitType type )
-    {
-        if (quantity == 0 || price <= 0) return;
-        auto limitOrder = std::make_unique<LimitOrder>(orderSide, quantity, orderID, price, type);
-        if(orderSide == OrderSide::Ask) fillAndRestLimitAsk(ticker, std::move(limitOrder));
-        else fillAndRestLimitBid(ticker, std::move(limitOrder));
-    }
-     
-    void MatchingEngine::submitMarketOrder(SymbolID ticker, OrderSide side, Quantity quantity, OrderID id)
-    {
-       if (quantity == 0) return;
-        MatchingEngine::fillMarketOrder(ticker, side, quantity, id);
-    }    
-      
-    void MatchingEngine::fillMarketOrder(SymbolID ticker, OrderSide marketSide, Quantity marketQty, OrderID marketID)
-    {
-        if (marketSide == OrderSide::Bid)
-        {
-         while (marketQty > 0 && book[ticker].hasAsks())
-        {
-            auto tradeopt{book[ticker].consumeBestAsk(marketQty)};
-            if(!tradeopt) break; 
-            ExecutionReport executedtrade = *tradeopt; 
-            marketQty -= executedtrade.executedQTY;
-            Trade trade{ticker, MatchingEngine::id++,executedtrade.restingPrice, executedtrade.executedQTY, marketID, executedtrade.restingID, marketSide};  
-            tradelog.record(trade); 
-        } 
-        } 
-        else 
-        {
-         while(marketQty > 0 && book[ticker].hasBids())
-            {
-                auto tradeopt{book[ticker].consumeBestBid(marketQty)};
-                if(!tradeopt) break; 
-                ExecutionReport executedtrade = *tradeopt; 
-                marketQty -= executedtrade.executedQTY;
-                Trade trade{ticker, MatchingEngine::id++, executedtrade.restingPrice, executedtrade.executedQTY, marketID, executedtrade.restingID, marketSide};
-                tradelog.record(trade);  
-            }
-        }
-    }
-    void MatchingEngine::fillAndRestLimitBid(SymbolID ticker, std::unique_ptr<LimitOrder> incomingOrder)
-    {
-        Price incomingPrice {incomingOrder->getPrice()};
-        LimitType type {incomingOrder->getType()};
-        OrderID oid {incomingOrder->getOrderID()};
-        while(incomingOrder->getQuantity() > 0 )
-         {
-            auto bestPriceOpt = book[ticker].bestAsk();
-            if(!bestPriceOpt) break; 
-            Price restingAsk =*bestPriceOpt;
-            if(incomingPrice < restingAsk) break;
-            if(type == LimitType::FOK){
-                if(!book[ticker].FOKVolumeCheck(OrderSide::Bid, incomingPrice, incomingOrder->getQuantity())) return;
-            }
-            auto executedTradeOpt{book[ticker].consumeBestAsk(incomingOrder->getQuantity())};
-            if(!executedTradeOpt) break;
-            ExecutionReport executedTrade = *executedTradeOpt;
-            if (executedTrade.executedQTY == 0) break; 
-            incomingOrder->updateQuantity(executedTrade.executedQTY);
-                Trade trade{
-                    ticker, 
-                    MatchingEngine::id++,
-                    executedTrade.restingPrice,
-                    executedTrade.executedQTY,
-                    oid,
-                    executedTrade.restingID,
-                    OrderSide::Bid
-                };
-             tradelog.record(trade);
-        } 
-        if(incomingOrder->getQuantity() > 0 && type == LimitType::GTC) {
-        idToSymbol[oid] = ticker;
-        book[ticker].addBid(std::move(incomingOrder));
-          
-    }
-    }
-
-
-    void MatchingEngine::fillAndRestLimitAsk(SymbolID ticker, std::unique_ptr<LimitOrder> incomingOrder)
-    {
-        Price incomingPrice {incomingOrder->getPrice()};
-        LimitType type {incomingOrder->getType()};
-        OrderID oid {incomingOrder->getOrderID()};
-        while(incomingOrder->getQuantity() > 0 )
-         {
-            auto bestPriceOpt = book[ticker].bestBid();
-            if(!bestPriceOpt) break; 
-            Price restingBid =*bestPriceOpt;
-            if(incomingPrice > restingBid) break;
-            if(type == LimitType::FOK){
-                if(!book[ticker].FOKVolumeCheck(OrderSide::Ask, incomingPrice, incomingOrder->getQuantity())) return;
-            }
-            auto executedTradeOpt{book[ticker].consumeBestBid(incomingOrder->getQuantity())};
-            if(!executedTradeOpt) break;
-            ExecutionReport executedTrade = *executedTradeOpt;
-            if (executedTrade.executedQTY == 0) break; 
-            incomingOrder->updateQuantity(executedTrade.executedQTY);
-                Trade trade{
-                    ticker, 
-                    MatchingEngine::id++,
-                    executedTrade.restingPrice,
-                    executedTrade.executedQTY,
-                    oid,
-                    executedTrade.restingID,
-                    OrderSide::Ask
-                };
-             tradelog.record(trade);
-        } 
-        if(incomingOrder->getQuantity() > 0 && type == LimitType::GTC)
-        {
-          idToSymbol[oid] = ticker;
-          book[ticker].addAsk(std::move(incomingOrder));
-        }
-      }
-
-    std::optional<SymbolID> MatchingEngine::requestModify(OrderID id)
-    {
-      auto it = idToSymbol.find(id);
-      if(it == idToSymbol.end()) return std::nullopt;
-      auto ticker {it->second};
-      if(book[ticker].orderExists(id)) return ticker;
-      return std::nullopt;
-    }
-    
-    bool MatchingEngine::cancelOrder(OrderID id)
-    {
-        auto orderexists = requestModify(id);
-        if(orderexists == std::nullopt) return false;
-        auto ticker {*orderexists};
-        book[ticker].cancelOrder(id);
-        return true;
-    }
-
-    bool MatchingEngine::reduceOrder(OrderID id, Quantity newQty) 
-    {
-      auto orderexists = requestModify(id);
-      if(orderexists == std::nullopt) return false;
-      auto ticker{*orderexists};
-      auto info = book[ticker].infoFromID(id);
-      const auto& order = *info.orderIT;
-      Quantity restingQTY = order->getQuantity();
-      if(newQty <= 0 || newQty >= restingQTY) return false;
-      book[ticker].reduceQuantity(id,newQty);
-      return true;
-    }
-
-    bool MatchingEngine::cancelReplace(OrderID id, Quantity newQTY, Price newPrice)
-    {
-      auto orderexists {requestModify(id)};
-      if(orderexists == std::nullopt) return false;
-      auto ticker{*orderexists};
-      auto info = book[ticker].infoFromID(id);
-      OrderSide side = info.side;
-      if(!cancelOrder(id)) return false;
-      MatchingEngine::submitLimitOrder(ticker,side, newQTY, OrderIDGenerator::next() , newPrice, LimitType::GTC);
-      return true;
-    }
-   
-    void MatchingEngine::printTrade(std::size_t index) const 
-    {
-        tradelog.printTrade(index);
-    }
-    std::size_t MatchingEngine::getLogSize() const
-    {
-        return tradelog.getTradeLogSize();
-    }
-
-    std::optional<Price> MatchingEngine::bestBid(SymbolID ticker) const
-    {
-        return book[ticker].bestBid();
-    }
-
-    std::optional<Price> MatchingEngine::bestAsk(SymbolID ticker) const
-    {
-        return book[ticker].bestAsk();
-    }
-
-    bool MatchingEngine::hasBid(SymbolID ticker) const
-    {
-        return book[ticker].hasBids();
-    }
-
-    bool MatchingEngine::hasAsk(SymbolID ticker) const
-    {
-        return book[ticker].hasAsks();
-    }
-
-
+#include "matching_engine_impl.hpp"
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+
+    // Upper bound on what a fixed-capacity engine allocates while it is built,
+    // with slack for alignment and for vectors that grow geometrically.
+    std::size_t engineArenaBytes(const EngineLimits& limits)
+    {
+        const auto ticks = static_cast<std::size_t>(limits.band.maxPrice - limits.band.minPrice) + 1;
+        const std::size_t bitmapWords = ticks / 64 + ticks / 4096 + 8;
+        const std::size_t side = ticks * sizeof(PriceLevel) + (ticks + 1) * sizeof(std::uint64_t)
+                               + bitmapWords * sizeof(std::uint64_t) + 1024;
+        const std::size_t chunks = (limits.maxOrdersPerBook + OrderPool::kChunkSize - 1) / OrderPool::kChunkSize;
+        const std::size_t pool = chunks * OrderPool::kChunkSize * sizeof(OrderNode) + 2 * chunks * 64 + 256;
+        const std::size_t books = limits.maxSymbols * (sizeof(OrderBook) + 2 * side + pool);
+        const std::size_t index = 2 * std::bit_ceil(std::max<std::size_t>(limits.maxOrders * 2, 16)) * sizeof(IndexEntry);
+        const std::size_t trades = std::bit_ceil(std::max<std::size_t>(limits.maxTrades, 1)) * sizeof(Trade);
+        const std::size_t tops = limits.maxSymbols * sizeof(TopOfBookCell) + kCacheLine;
+        const std::size_t total = books + index + trades + tops;
+        return total + total / 8 + (std::size_t{1} << 20);
+    }
+
+    const EngineLimits& checkedLimits(const EngineLimits& limits)
+    {
+        if(limits.maxSymbols == 0 || limits.maxOrdersPerBook == 0 || limits.maxOrders == 0 || limits.maxTrades == 0)
+            throw std::invalid_argument("EngineLimits needs non-zero symbol, order and trade counts");
+        if(!validBand(limits.band))
+            throw std::invalid_argument("EngineLimits band must be positive with minPrice <= maxPrice");
+        return limits;
+    }
+
+    template struct BasicMatchingEngine<TradeLogSink>;
+    template struct BasicMatchingEngine<NullSink>;
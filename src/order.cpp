@@ -1,13 +1,35 @@
 #include "order.hpp"
 #include <atomic>
 
+    namespace
+    {
+    std::atomic<OrderID> g_nextID{1};
+    }
+
     int OrderIDGenerator::max {1};
 
     OrderID OrderIDGenerator::next()
     {
-        static std::atomic<OrderID> id{1};
-        max = {id + 1};
-        return id.fetch_add(1, std::memory_order_relaxed);
+        max = {g_nextID + 1};
+        return g_nextID.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    OrderID OrderIDGenerator::peek()
+    {
+        return g_nextID.load(std::memory_order_relaxed);
+    }
+
+    void OrderIDGenerator::reset(OrderID nextID)
+    {
+        g_nextID.store(nextID, std::memory_order_relaxed);
+        max = {nextID};
+    }
+
+    void OrderIDGenerator::advancePast(OrderID id)
+    {
+        OrderID current = g_nextID.load(std::memory_order_relaxed);
+        while (current <= id && !g_nextID.compare_exchange_weak(current, id + 1, std::memory_order_relaxed)) {}
+        max = {g_nextID.load(std::memory_order_relaxed)};
     }
   
        
@@ -1,34 +1,247 @@
 #include "order_book.hpp"
 #include "order.hpp"
+#include <algorithm>
+#include <memory>
 #include <optional>
+#include <type_traits>
 
+    OrderBook::OrderBook(std::pmr::memory_resource* resource)
+    : m_BidSide{resource}
+    , m_AskSide{resource}
+    , m_pool{resource}
+    , m_depthFeed{resource}
+    {}
 
-    
+    OrderBook::OrderBook(PriceBand band, std::pmr::memory_resource* resource)
+    : m_BidSide{band, resource}
+    , m_AskSide{band, resource}
+    , m_pool{resource}
+    , m_depthFeed{resource}
+    {}
+
+    void OrderBook::reset()
+    {
+        m_depthFeed.touchAll(m_BidSide, m_AskSide);
+        m_BidSide.clear();
+        m_AskSide.clear();
+        m_pool.clear();
+        republishDepthView();
+    }
+
+    // Rebuilt in place: assigning would keep the old vectors' resource, since
+    // polymorphic allocators do not propagate.
+    void OrderBook::trackDepth(std::size_t depth, std::pmr::memory_resource* resource)
+    {
+        std::destroy_at(&m_depthFeed);
+        std::construct_at(&m_depthFeed, resource);
+        m_depthFeed.enable(depth);
+    }
+
+    std::span<const DepthUpdate> OrderBook::collectDepth()
+    {
+        return m_depthFeed.collect(m_BidSide, m_AskSide);
+    }
+
+    // Publishes the current book at once, so the first image readers see
+    // is epoch 1 rather than the empty one.
+    void OrderBook::publishDepthView(DepthViewCadence cadence, std::pmr::memory_resource* resource)
+    {
+        std::size_t levelHint = 0;
+        if (const auto ladder = band()) levelHint = static_cast<std::size_t>(ladder->maxPrice - ladder->minPrice) + 1;
+        m_view = std::make_unique<PublishedDepth>(cadence, levelHint, resource);
+        m_view->refresh(m_BidSide, m_AskSide);
+    }
+
+    std::optional<PriceBand> OrderBook::band() const
+    {
+        if (!isLadder()) return std::nullopt;
+        return m_BidSide.band();
+    }
+
+    bool OrderBook::isLadder() const
+    {
+        return m_BidSide.isLadder();
+    }
+
+    bool OrderBook::acceptsPrice(Price price) const
+    {
+        return m_BidSide.inBand(price);
+    }
+
+    template<OrderSide S>
+    OrderHandle OrderBook::add(const LimitOrder& order)
+    {
+       auto& side = ownSide<S>();
+       const Price price = order.getPrice();
+       auto& level = side.levelFor(price);
+       const OrderHandle handle = m_pool.create(order.getOrderID(), order.getQuantity());
+       level.orders.pushBack(m_pool, handle);
+       side.addQuantity(level, price, order.getQuantity());
+       m_depthFeed.touch<S>(price);
+       return handle;
+    }
+
+    // A level is erased as soon as its queue empties, so levelQTY is kept equal to
+    // the sum of the resting quantities in the queue on every fill.
+    template<OrderSide Aggressor>
+    std::optional<ExecutionReport> OrderBook::consumeBest(Quantity quantity)
+    {
+        auto& side = oppositeSide<Aggressor>();
+        if (side.empty()) return std::nullopt;
+        auto& level = side.bestLevel();
+        const Price rPrice{side.bestPrice()};
+        const OrderHandle front = level.orders.front();
+        OrderNode& restingOrder = m_pool[front];
+        Quantity executed = std::min(quantity, restingOrder.qty);
+        if (executed == 0) return std::nullopt;
+        restingOrder.qty -= executed;
+        const OrderID rID{restingOrder.id};
+        const Quantity remaining{restingOrder.qty};
+        side.removeQuantity(level, rPrice, executed);
+        m_depthFeed.touch<opposite(Aggressor)>(rPrice);
+        if (remaining == 0)
+        {
+            level.orders.erase(m_pool, front);
+            m_pool.destroy(front);
+        }
+        if (level.orders.empty())
+        {
+            side.eraseBest();
+        }
+        return ExecutionReport{rPrice, rID, executed, remaining};
+    }
+
+    // One loop over levels and the orders in them; the level is only erased
+    // once, after its queue runs dry. A level the aggressor covers entirely
+    // takes the whole-level path instead of being peeled order by order. Either
+    // way the level's aggregates are settled once per level: eraseBest retires
+    // all of levelQTY, or removeQuantity takes off what was filled.
+    template<OrderSide Aggressor>
+    Quantity OrderBook::sweep(Quantity quantity, Price limit, std::span<ExecutionReport> out, std::size_t& written)
+    {
+        auto& side = oppositeSide<Aggressor>();
+        using Side = std::remove_reference_t<decltype(side)>;
+        written = 0;
+        while (quantity > 0 && !side.empty() && written < out.size())
+        {
+            const Price price = side.bestPrice();
+            if (!Side::noWorseThan(price, limit)) break;
+            PriceLevel& level = side.bestLevel();
+            m_depthFeed.touch<opposite(Aggressor)>(price);
+            if (quantity >= level.levelQTY)
+            {
+                // Every order here fills completely: report them, hand the whole
+                // chain back to the pool in one splice and drop the level, without
+                // touching the orders' quantities or levelQTY on the way.
+                const OrderHandle first = level.orders.front();
+                OrderHandle last = kNullHandle;
+                OrderHandle cursor = first;
+                Quantity taken{};
+                std::size_t count{};
+                while (cursor != kNullHandle && written < out.size())
+                {
+                    const OrderNode& node = m_pool[cursor];
+                    out[written++] = ExecutionReport{price, node.id, node.qty, 0};
+                    taken += node.qty;
+                    last = cursor;
+                    cursor = node.next;
+                    ++count;
+                }
+                level.orders.dropFront(m_pool, cursor, static_cast<std::uint32_t>(count));
+                m_pool.destroyChain(first, last, count);
+                quantity -= taken;
+                if (cursor == kNullHandle) side.eraseBest();
+                else side.removeQuantity(level, price, taken); // out filled part-way through the level
+                continue;
+            }
+            Quantity taken{};
+            while (quantity > 0 && !level.orders.empty() && written < out.size())
+            {
+                const OrderHandle front = level.orders.front();
+                OrderNode& restingOrder = m_pool[front];
+                const Quantity executed = std::min(quantity, restingOrder.qty);
+                restingOrder.qty -= executed;
+                taken += executed;
+                quantity -= executed;
+                const Quantity remaining = restingOrder.qty;
+                out[written++] = ExecutionReport{price, restingOrder.id, executed, remaining};
+                if (remaining == 0)
+                {
+                    level.orders.popFront(m_pool);
+                    m_pool.destroy(front);
+                }
+            }
+            if (level.orders.empty()) side.eraseBest();
+            else side.removeQuantity(level, price, taken);
+        }
+        return quantity;
+    }
+
+    // Checked once per FOK order, before any liquidity is taken.
+    template<OrderSide Aggressor>
+    bool OrderBook::FOKVolumeCheck(Price price, Quantity volume)
+    {
+        return oppositeSide<Aggressor>().hasDepth(price, volume);
+    }
+
+    template<OrderSide S>
+    Quantity OrderBook::cancelOrder(OrderHandle handle, Price price)
+    {
+        auto& side = ownSide<S>();
+        auto& level = *side.find(price);
+        const Quantity cancelledQTY = m_pool[handle].qty;
+        side.removeQuantity(level, price, cancelledQTY);
+        m_depthFeed.touch<S>(price);
+        level.orders.erase(m_pool, handle);
+        if(level.orders.empty()) side.erase(price);
+        m_pool.destroy(handle);
+        return cancelledQTY;
+    }
+
+    template<OrderSide S>
+    void OrderBook::reduceQuantity(OrderHandle handle, Price price, Quantity newQTY)
+    {
+        auto& side = ownSide<S>();
+        OrderNode& order = m_pool[handle];
+        const Quantity removedQTY = order.qty - newQTY;
+        order.qty = newQTY;
+        side.removeQuantity(*side.find(price), price, removedQTY);
+        m_depthFeed.touch<S>(price);
+    }
+
+    template OrderHandle OrderBook::add<OrderSide::Bid>(const LimitOrder&);
+    template OrderHandle OrderBook::add<OrderSide::Ask>(const LimitOrder&);
+    template std::optional<ExecutionReport> OrderBook::consumeBest<OrderSide::Bid>(Quantity);
+    template std::optional<ExecutionReport> OrderBook::consumeBest<OrderSide::Ask>(Quantity);
+    template Quantity OrderBook::sweep<OrderSide::Bid>(Quantity, Price, std::span<ExecutionReport>, std::size_t&);
+    template Quantity OrderBook::sweep<OrderSide::Ask>(Quantity, Price, std::span<ExecutionReport>, std::size_t&);
+    template bool OrderBook::FOKVolumeCheck<OrderSide::Bid>(Price, Quantity);
+    template bool OrderBook::FOKVolumeCheck<OrderSide::Ask>(Price, Quantity);
+    template Quantity OrderBook::cancelOrder<OrderSide::Bid>(OrderHandle, Price);
+    template Quantity OrderBook::cancelOrder<OrderSide::Ask>(OrderHandle, Price);
+    template void OrderBook::reduceQuantity<OrderSide::Bid>(OrderHandle, Price, Quantity);
+    template void OrderBook::reduceQuantity<OrderSide::Ask>(OrderHandle, Price, Quantity);
   
-    void OrderBook::addBid( std::unique_ptr<LimitOrder> order)
+    OrderHandle OrderBook::addBid(const LimitOrder& order)
     {
-       const Price price = order->getPrice();
-       const OrderID id = order->getOrderID();
-       const Quantity qty = order->getQuantity(); 
-       auto [levelIT, inserted] = m_BidSide.try_emplace(price);
-       auto& level = levelIT->second; 
-       auto orderIT = level.orders.insert(level.orders.end(), std::move(order));
-       level.levelQTY += qty;
-       m_lookup[id] =  LookUp{ OrderSide::Bid, orderIT, price,qty };
+       return add<OrderSide::Bid>(order);
     }
   
-    void OrderBook::addAsk( std::unique_ptr<LimitOrder> order)
+    OrderHandle OrderBook::addAsk(const LimitOrder& order)
     { 
-       const Price price = order->getPrice();
-       const OrderID id = order->getOrderID();
-       const Quantity qty = order->getQuantity(); 
-       auto [levelIT, inserted] = m_AskSide.try_emplace(price);
-       auto& level = levelIT->second; 
-       auto orderIT = level.orders.insert(level.orders.end(), std::move(order));
-       level.levelQTY += qty;
-       m_lookup[id] =  LookUp{ OrderSide::Ask, orderIT, price,qty}; 
+       return add<OrderSide::Ask>(order);
+    }
+
+    void OrderBook::reserveOrders(std::size_t count)
+    {
+        m_pool.reserve(count);
     }
    
+    std::size_t OrderBook::restingOrders() const
+    {
+        return m_pool.capacity() - m_pool.available();
+    }
+
     bool OrderBook::hasAsks() const
     {
         return !m_AskSide.empty();
@@ -42,132 +255,58 @@
     std::optional<Price> OrderBook::bestBid() const
     {
         if (m_BidSide.empty()) return std::nullopt;
-        if (m_BidSide.begin()->second.orders.empty()) return std::nullopt;
-        return m_BidSide.begin()->first;
+        return m_BidSide.bestPrice();
     }
 
     std::optional<Price> OrderBook::bestAsk() const
     {
         if (m_AskSide.empty()) return std::nullopt;
-        if (m_AskSide.begin()->second.orders.empty()) return std::nullopt;
-        return m_AskSide.begin()->first;
+        return m_AskSide.bestPrice();
     }
-   
+
+    void OrderBook::depth(std::size_t levels, DepthBuffer& out) const
+    {
+        const std::size_t bids = std::min(levels, out.bidPrices.size());
+        const std::size_t asks = std::min(levels, out.askPrices.size());
+        out.bids = m_BidSide.topLevels(out.bidPrices.first(bids), out.bidQuantities);
+        out.asks = m_AskSide.topLevels(out.askPrices.first(asks), out.askQuantities);
+    }
+
     std::optional<ExecutionReport> OrderBook::consumeBestAsk(Quantity quantity)
     {   
-        if (m_AskSide.empty()) return std::nullopt;
-        auto priceIt = m_AskSide.begin();
-        auto& orderQueue = priceIt->second.orders; 
-        if (orderQueue.empty()) return std::nullopt;
-        LimitOrder& restingOrder = *orderQueue.front(); 
-        Quantity executed = std::min(quantity, restingOrder.getQuantity());
-        if(executed == 0) return std::nullopt;
-        restingOrder.updateQuantity(executed);
-        OrderID rID{restingOrder.getOrderID()};
-        Price rPrice{restingOrder.getPrice()};
-        if (restingOrder.getQuantity() == 0)
-        {
-            m_lookup.erase(rID);
-            orderQueue.pop_front();
-        }
-        if (orderQueue.empty())
-        {
-            m_AskSide.erase(priceIt);
-        }
-        return ExecutionReport{rPrice, rID, executed};
-
+        return consumeBest<OrderSide::Bid>(quantity);
     }
+
     std::optional<ExecutionReport> OrderBook::consumeBestBid(Quantity quantity)
     {
-        if (m_BidSide.empty()) return std::nullopt;
-        auto priceIt = m_BidSide.begin();
-        auto& orderQueue = priceIt->second.orders;
-        if (orderQueue.empty()) return std::nullopt;
-        LimitOrder& restingOrder = *orderQueue.front();
-        Quantity executed = std::min(quantity, restingOrder.getQuantity());
-        if (executed == 0) return std::nullopt;
-        restingOrder.updateQuantity(executed);
-        OrderID rID{restingOrder.getOrderID()};
-        Price rPrice{restingOrder.getPrice()};
-        if (restingOrder.getQuantity() == 0)
-        {
-            m_lookup.erase(rID);
-            orderQueue.pop_front();
-        }
-        if (orderQueue.empty())
-        {
-            m_BidSide.erase(priceIt);
-        }
-        return ExecutionReport{rPrice, rID, executed};
+        return consumeBest<OrderSide::Ask>(quantity);
     }
-
     
-    bool OrderBook::orderExists(OrderID id)
+    Quantity OrderBook::restingQuantity(const LookUp& info) const
     {
-        if(m_lookup.contains(id))
-        {
-          return true;
-        }
-        return false;
+        return m_pool[info.handle].qty;
     }
-    
-    LookUp OrderBook::infoFromID(OrderID id)
+  
+    Quantity OrderBook::sweep(OrderSide aggressorSide, Quantity quantity, Price limit, std::span<ExecutionReport> out, std::size_t& written)
     {
-      return m_lookup[id];
+        if (aggressorSide == OrderSide::Bid) return sweep<OrderSide::Bid>(quantity, limit, out, written);
+        return sweep<OrderSide::Ask>(quantity, limit, out, written);
     }
-  
+
     bool OrderBook::FOKVolumeCheck(OrderSide side, Price price, Quantity volume)
     {
-        if(side == OrderSide::Bid) {
-         Quantity restingQTY{};
-        for(const auto& pair : m_AskSide) 
-        {
-            if(pair.first > price) return false;
-            restingQTY += pair.second.levelQTY;
-            if(restingQTY >= volume) return true;
-        }
-        return false;
+        if(side == OrderSide::Bid) return FOKVolumeCheck<OrderSide::Bid>(price, volume);
+        return FOKVolumeCheck<OrderSide::Ask>(price, volume);
     }
-        else { 
-         Quantity restingQTY{};
-        for(const auto& pair : m_BidSide) 
-        {
-            if(pair.first < price) return false;
-            restingQTY += pair.second.levelQTY;
-            if(restingQTY >= volume) return true;
-        }
-        return false;
-     }        
-    }
-    void OrderBook::cancelOrder(OrderID id)
+
+    Quantity OrderBook::cancelOrder(const LookUp& info)
     {    
-       LookUp info = m_lookup[id]; 
-       Price price = info.price;
-       const auto& order = *info.orderIT;
-       Quantity removingQty = order->getQuantity();
-       if(info.side == OrderSide::Bid)
-       {   
-        auto mapIt = m_BidSide.find(price);
-        mapIt->second.levelQTY -= removingQty;
-        mapIt->second.orders.erase(info.orderIT);
-        if(mapIt->second.levelQTY == 0 ) m_BidSide.erase(price);
-       }
-      else
-      {
-        auto mapIt = m_AskSide.find(price);
-        mapIt->second.levelQTY -= removingQty;
-        mapIt->second.orders.erase(info.orderIT);
-        if(mapIt->second.levelQTY == 0 ) m_AskSide.erase(price);
-      }
-      m_lookup.erase(id);
+        if(info.side() == OrderSide::Bid) return cancelOrder<OrderSide::Bid>(info.handle, info.price());
+        return cancelOrder<OrderSide::Ask>(info.handle, info.price());
     }
      
-    void OrderBook::reduceQuantity(OrderID id, Quantity newQTY)
+    void OrderBook::reduceQuantity(const LookUp& info, Quantity newQTY)
     {
-        LookUp info = m_lookup[id];
-        auto const& order = *info.orderIT;
-        order->setQuantity(newQTY); 
-      
+        if(info.side() == OrderSide::Bid) reduceQuantity<OrderSide::Bid>(info.handle, info.price(), newQTY);
+        else reduceQuantity<OrderSide::Ask>(info.handle, info.price(), newQTY);
     }
-
-           
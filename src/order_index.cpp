@@ -0,0 +1,102 @@
+#include "order_index.hpp"
+#include <bit>
+
+    void OrderIndex::rehash(std::size_t capacity)
+    {
+        std::pmr::vector<IndexEntry> old(m_slots.get_allocator());
+        old.swap(m_slots);
+        m_slots.assign(capacity, IndexEntry{kEmpty, 0, LookUp{}});
+        m_mask = capacity - 1;
+        m_shift = 64 - static_cast<unsigned>(std::countr_zero(capacity));
+        m_size = 0;
+        for (const IndexEntry& entry : old)
+        {
+            if (entry.id != kEmpty) insert(entry.id, entry.symbol, entry.location);
+        }
+    }
+
+    void OrderIndex::restore(std::span<const IndexEntry> slots, std::size_t size)
+    {
+        m_slots.assign(slots.begin(), slots.end());
+        m_mask = slots.empty() ? 0 : slots.size() - 1;
+        m_shift = slots.empty() ? 64 : 64 - static_cast<unsigned>(std::countr_zero(slots.size()));
+        m_size = size;
+    }
+
+    void OrderIndex::reserve(std::size_t count)
+    {
+        const std::size_t capacity = std::bit_ceil(std::max<std::size_t>(count * 2, 16));
+        if (capacity > m_slots.size()) rehash(capacity);
+    }
+
+    void OrderIndex::clear()
+    {
+        for (IndexEntry& slot : m_slots) slot.id = kEmpty;
+        m_size = 0;
+    }
+
+    bool OrderIndex::insert(OrderID id, std::uint32_t symbol, LookUp location)
+    {
+        if ((m_size + 1) * 2 > m_slots.size()) rehash(std::max<std::size_t>(m_slots.size() * 2, 16));
+        for (std::size_t i = home(id);; i = (i + 1) & m_mask)
+        {
+            IndexEntry& slot = m_slots[i];
+            if (slot.id == id) return false;
+            if (slot.id != kEmpty) continue;
+            slot = IndexEntry{id, symbol, location};
+            ++m_size;
+            return true;
+        }
+    }
+
+    IndexEntry* OrderIndex::find(OrderID id)
+    {
+        if (m_size == 0 || id == kEmpty) return nullptr;
+        for (std::size_t i = home(id);; i = (i + 1) & m_mask)
+        {
+            IndexEntry& slot = m_slots[i];
+            if (slot.id == id) return &slot;
+            if (slot.id == kEmpty) return nullptr;
+        }
+    }
+
+    // Backward-shift deletion: walk the run after the hole and pull back every
+    // entry whose home slot does not lie cyclically in (hole, current], so every
+    // remaining entry stays reachable from its home without tombstones.
+    void OrderIndex::erase(IndexEntry* entry)
+    {
+        std::size_t hole = static_cast<std::size_t>(entry - m_slots.data());
+        for (std::size_t i = (hole + 1) & m_mask; m_slots[i].id != kEmpty; i = (i + 1) & m_mask)
+        {
+            const std::size_t want = home(m_slots[i].id);
+            const bool stays = hole <= i ? (hole < want && want <= i) : (hole < want || want <= i);
+            if (stays) continue;
+            m_slots[hole] = m_slots[i];
+            hole = i;
+        }
+        m_slots[hole].id = kEmpty;
+        --m_size;
+    }
+
+    bool OrderIndex::erase(OrderID id)
+    {
+        IndexEntry* entry = find(id);
+        if (entry == nullptr) return false;
+        erase(entry);
+        return true;
+    }
+
+    std::size_t OrderIndex::size() const
+    {
+        return m_size;
+    }
+
+    std::size_t OrderIndex::capacity() const
+    {
+        return m_slots.size();
+    }
+
+    void OrderIndex::prefetch(OrderID id) const
+    {
+        if (!m_slots.empty()) __builtin_prefetch(&m_slots[home(id)]);
+    }
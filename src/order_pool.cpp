@@ -0,0 +1,97 @@
+#include "order_pool.hpp"
+#include <algorithm>
+
+    void OrderPool::grow()
+    {
+        m_chunks.emplace_back(kChunkSize);
+        m_free += kChunkSize;
+    }
+
+    void OrderPool::reserve(std::size_t count)
+    {
+        while (m_free < count) grow();
+    }
+
+    // Recycled slots are reused before fresh ones are carved, and the most
+    // recently released slot comes first since it is likely still in cache.
+    OrderHandle OrderPool::create(OrderID id, Quantity qty)
+    {
+        OrderHandle handle;
+        if (m_freeHead != kNullHandle)
+        {
+            handle = m_freeHead;
+            m_freeHead = (*this)[handle].next;
+        }
+        else
+        {
+            if (m_carved == m_chunks.size() * kChunkSize) grow();
+            handle = static_cast<OrderHandle>(m_carved++);
+        }
+        --m_free;
+        OrderNode& node = (*this)[handle];
+        node.id = id;
+        node.qty = qty;
+        node.prev = kNullHandle;
+        node.next = kNullHandle;
+        return handle;
+    }
+
+    void OrderPool::destroy(OrderHandle handle)
+    {
+        (*this)[handle].next = m_freeHead;
+        m_freeHead = handle;
+        ++m_free;
+    }
+
+    void OrderPool::destroyChain(OrderHandle first, OrderHandle last, std::size_t count)
+    {
+        (*this)[last].next = m_freeHead;
+        m_freeHead = first;
+        m_free += count;
+    }
+
+    void OrderPool::clear()
+    {
+        m_freeHead = kNullHandle;
+        m_carved = 0;
+        m_free = capacity();
+    }
+
+    void OrderPool::restore(std::span<const OrderNode> nodes, OrderHandle freeHead, std::size_t freeCount)
+    {
+        while (capacity() < nodes.size()) grow();
+        for (std::size_t copied = 0; copied < nodes.size(); copied += kChunkSize)
+        {
+            const std::size_t count = std::min(kChunkSize, nodes.size() - copied);
+            std::copy_n(nodes.begin() + static_cast<std::ptrdiff_t>(copied), count, m_chunks[copied >> kChunkShift].begin());
+        }
+        m_carved = nodes.size();
+        m_freeHead = freeHead;
+        m_free = capacity() - m_carved + freeCount;
+    }
+
+    std::size_t OrderPool::available() const
+    {
+        return m_free;
+    }
+
+    void OrderQueue::pushBack(OrderPool& pool, OrderHandle handle)
+    {
+        OrderNode& node = pool[handle];
+        node.prev = tail;
+        node.next = kNullHandle;
+        if (tail == kNullHandle) head = handle;
+        else pool[tail].next = handle;
+        tail = handle;
+        ++count;
+    }
+
+    void OrderQueue::erase(OrderPool& pool, OrderHandle handle)
+    {
+        OrderNode& node = pool[handle];
+        if (node.prev == kNullHandle) head = node.next;
+        else pool[node.prev].next = node.next;
+        if (node.next == kNullHandle) tail = node.prev;
+        else pool[node.next].prev = node.prev;
+        --count;
+    }
@@ -0,0 +1,163 @@
+#include "sharded_engine.hpp"
+#include <stdexcept>
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+    namespace
+    {
+    constexpr std::size_t kDrainBatch = 64;
+
+    void pinToCore(std::size_t core)
+    {
+#if defined(__linux__)
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(core, &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+        (void)core;
+#endif
+    }
+    }
+
+    ShardedEngine::Shard::Shard(std::size_t queueCapacity)
+    : inbox{queueCapacity}
+    {}
+
+    ShardedEngine::ShardedEngine(std::size_t numberofsymbols, std::size_t shardCount,
+                                 std::optional<PriceBand> band,
+                                 std::size_t queueCapacity, bool pinThreads)
+    {
+        if (shardCount == 0) throw std::invalid_argument("ShardedEngine needs at least one shard");
+        const std::size_t cores = std::max(1u, std::thread::hardware_concurrency());
+        m_shards.reserve(shardCount);
+        for (std::size_t s = 0; s < shardCount; ++s) m_shards.push_back(std::make_unique<Shard>(queueCapacity));
+        for (std::size_t s = 0; s < shardCount; ++s)
+        {
+            Shard& shard = *m_shards[s];
+            const std::size_t symbols = numberofsymbols / shardCount + (s < numberofsymbols % shardCount ? 1 : 0);
+            shard.worker = std::thread([this, &shard, s, symbols, band, core = s % cores, pinThreads]
+                                       { run(shard, s, symbols, band, core, pinThreads); });
+        }
+        for (auto& shard : m_shards)
+        {
+            while (!shard->ready.load(std::memory_order_acquire)) std::this_thread::yield();
+        }
+    }
+
+    ShardedEngine::~ShardedEngine()
+    {
+        stop();
+    }
+
+    // Drain in batches while commands are queued; when idle, yield rather than
+    // burn the core so an oversubscribed machine still makes progress.
+    void ShardedEngine::run(Shard& shard, std::size_t index, std::size_t symbols, std::optional<PriceBand> band, std::size_t core, bool pin)
+    {
+        if (pin) pinToCore(core);
+        if (band) shard.engine.emplace(symbols, *band);
+        else shard.engine.emplace(symbols);
+        shard.engine->id = TradeID{index} << kTradeIDShardShift;
+        shard.ready.store(true, std::memory_order_release);
+        Command batch[kDrainBatch];
+        while (true)
+        {
+            const std::size_t count = shard.inbox.popBatch(batch, kDrainBatch);
+            if (count == 0)
+            {
+                if (!m_running.load(std::memory_order_acquire) && shard.inbox.size() == 0) return;
+                std::this_thread::yield();
+                continue;
+            }
+            for (std::size_t i = 0; i < count; ++i) shard.engine->execute(batch[i]);
+            shard.processed.fetch_add(count, std::memory_order_release);
+        }
+    }
+
+    void ShardedEngine::submit(const Command& command)
+    {
+        Shard& shard = *m_shards[shardOf(command.ticker)];
+        Command local = command;
+        local.ticker = localTicker(command.ticker);
+        while (!shard.inbox.tryPush(local)) std::this_thread::yield();
+        ++shard.submitted;
+    }
+
+    void ShardedEngine::submitLimitOrder(SymbolID ticker, OrderSide side, Quantity quantity, OrderID id, Price price, LimitType type)
+    {
+        submit(Command::limit(ticker, side, quantity, id, price, type));
+    }
+
+    void ShardedEngine::submitMarketOrder(SymbolID ticker, OrderSide side, Quantity quantity, OrderID id)
+    {
+        submit(Command::market(ticker, side, quantity, id));
+    }
+
+    void ShardedEngine::cancelOrder(SymbolID ticker, OrderID id)
+    {
+        submit(Command::cancel(id, ticker));
+    }
+
+    void ShardedEngine::reduceOrder(SymbolID ticker, OrderID id, Quantity newQty)
+    {
+        submit(Command::reduce(id, newQty, ticker));
+    }
+
+    void ShardedEngine::cancelReplace(SymbolID ticker, OrderID id, Quantity newQty, Price newPrice)
+    {
+        submit(Command::cancelReplace(id, newQty, newPrice, ticker, OrderIDGenerator::next()));
+    }
+
+    void ShardedEngine::flush()
+    {
+        for (auto& shard : m_shards)
+        {
+            while (shard->processed.load(std::memory_order_acquire) != shard->submitted)
+            {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    void ShardedEngine::stop()
+    {
+        m_running.store(false, std::memory_order_release);
+        for (auto& shard : m_shards)
+        {
+            if (shard->worker.joinable()) shard->worker.join();
+        }
+    }
+
+    std::size_t ShardedEngine::shardCount() const
+    {
+        return m_shards.size();
+    }
+
+    std::size_t ShardedEngine::shardOf(SymbolID ticker) const
+    {
+        return ticker % m_shards.size();
+    }
+
+    SymbolID ShardedEngine::localTicker(SymbolID ticker) const
+    {
+        return ticker / m_shards.size();
+    }
+
+    const MatchingEngine& ShardedEngine::engineFor(SymbolID ticker) const
+    {
+        return *m_shards[shardOf(ticker)]->engine;
+    }
+
+    const MatchingEngine& ShardedEngine::shard(std::size_t index) const
+    {
+        return *m_shards[index]->engine;
+    }
+
+    std::size_t ShardedEngine::getLogSize() const
+    {
+        std::size_t total{};
+        for (const auto& shard : m_shards) total += shard->engine->getLogSize();
+        return total;
+    }
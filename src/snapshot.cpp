@@ -0,0 +1,382 @@
+#include "snapshot.hpp"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+    namespace
+    {
+    constexpr char kMagic[8] = {'O', 'B', 'S', 'N', 'A', 'P', 'S', 'H'};
+    constexpr std::uint32_t kVersion = 2;
+    constexpr std::uint64_t kAlign = 64;
+
+    constexpr std::uint64_t alignUp(std::uint64_t offset)
+    {
+        return (offset + kAlign - 1) & ~(kAlign - 1);
+    }
+
+    // Buffered sequential writer on a raw descriptor. The buffer lives on the
+    // stack, so writing a snapshot never touches the heap.
+    class FileWriter
+    {
+        private:
+        int m_fd;
+        std::array<char, 64 * 1024> m_buffer;
+        std::size_t m_used{};
+        std::uint64_t m_offset{};
+        bool m_ok{true};
+
+        void drain()
+        {
+            const char* next = m_buffer.data();
+            std::size_t left = m_used;
+            while (left > 0 && m_ok)
+            {
+                const ssize_t done = ::write(m_fd, next, left);
+                if (done < 0)
+                {
+                    if (errno != EINTR) m_ok = false;
+                    continue;
+                }
+                next += done;
+                left -= static_cast<std::size_t>(done);
+            }
+            m_used = 0;
+        }
+
+        public:
+        explicit FileWriter(int fd)
+        : m_fd{fd}
+        {}
+
+        void put(const void* data, std::size_t bytes)
+        {
+            const char* next = static_cast<const char*>(data);
+            m_offset += bytes;
+            while (bytes > 0)
+            {
+                if (m_used == m_buffer.size()) drain();
+                const std::size_t count = std::min(bytes, m_buffer.size() - m_used);
+                std::memcpy(m_buffer.data() + m_used, next, count);
+                m_used += count;
+                next += count;
+                bytes -= count;
+            }
+        }
+
+        template<typename T>
+        void put(const T& value) { put(&value, sizeof(T)); }
+
+        // Zero-fills up to offset, the start of the next section.
+        void padTo(std::uint64_t offset)
+        {
+            constexpr std::array<char, kAlign> zeros{};
+            while (m_offset < offset) put(zeros.data(), static_cast<std::size_t>(std::min<std::uint64_t>(offset - m_offset, kAlign)));
+        }
+
+        // Writes out the buffer and syncs; false if anything failed.
+        bool finish()
+        {
+            drain();
+            return m_ok && ::fsync(m_fd) == 0;
+        }
+    };
+
+    // The table entry for book, placing its sections at offset and moving
+    // offset past them. Both writing passes call this, so they agree.
+    SnapshotBook describe(const OrderBook& book, std::uint64_t& offset)
+    {
+        SnapshotBook entry{};
+        entry.isLadder = book.isLadder() ? 1 : 0;
+        if (const auto band = book.band())
+        {
+            entry.minPrice = band->minPrice;
+            entry.maxPrice = band->maxPrice;
+        }
+        entry.freeHead = book.m_pool.freeHead();
+        entry.bidLevels = static_cast<std::uint32_t>(book.m_BidSide.levelCount());
+        entry.askLevels = static_cast<std::uint32_t>(book.m_AskSide.levelCount());
+        entry.carved = book.m_pool.carved();
+        entry.freeCount = entry.carved - book.restingOrders();
+        entry.levelsOffset = offset;
+        offset = alignUp(offset + (std::uint64_t{entry.bidLevels} + entry.askLevels) * sizeof(SnapshotLevel));
+        entry.nodesOffset = offset;
+        offset = alignUp(offset + entry.carved * sizeof(OrderNode));
+        return entry;
+    }
+
+    template<typename Side>
+    void putLevels(FileWriter& out, const Side& side)
+    {
+        side.forEachLevel([&](Price price, const PriceLevel& level)
+        {
+            out.put(SnapshotLevel{price, level.levelQTY, level.orders.head, level.orders.tail, level.orders.count});
+            return true;
+        });
+    }
+
+    void putNodes(FileWriter& out, const OrderPool& pool)
+    {
+        for (std::size_t first = 0, chunk = 0; first < pool.carved(); first += OrderPool::kChunkSize, ++chunk)
+        {
+            const std::size_t count = std::min(OrderPool::kChunkSize, pool.carved() - first);
+            out.put(pool.chunk(chunk).data(), count * sizeof(OrderNode));
+        }
+    }
+
+    bool handleOK(OrderHandle handle, std::uint64_t carved)
+    {
+        return handle == kNullHandle || handle < carved;
+    }
+
+    // What compatible() has found each carved slot to be while walking a book.
+    constexpr std::uint32_t kUnseen = 0;
+    constexpr std::uint32_t kFreeSlot = 1;
+    constexpr std::uint32_t kIndexed = UINT32_MAX;
+
+    constexpr std::uint32_t levelTag(std::size_t level) { return static_cast<std::uint32_t>(level) + 2; }
+
+    // Walks the free list and every level's queue of one book, tagging each slot
+    // with the level that owns it. Fails unless levels are strictly best first,
+    // each queue is one acyclic chain from head to tail whose count and
+    // quantities agree with its level, and every carved slot is reached once.
+    bool checkBook(const MappedSnapshot& snapshot, const SnapshotBook& entry, const OrderBook& book, std::vector<std::uint32_t>& tags)
+    {
+        if (entry.freeCount > entry.carved || !handleOK(entry.freeHead, entry.carved)) return false;
+        const auto nodes = snapshot.nodes(entry);
+        tags.assign(nodes.size(), kUnseen);
+        for (const OrderNode& node : nodes)
+        {
+            if (!handleOK(node.prev, entry.carved) || !handleOK(node.next, entry.carved)) return false;
+        }
+
+        OrderHandle handle = entry.freeHead;
+        for (std::uint64_t i = 0; i < entry.freeCount; ++i)
+        {
+            if (handle == kNullHandle || tags[handle] != kUnseen) return false;
+            tags[handle] = kFreeSlot;
+            handle = nodes[handle].next;
+        }
+        if (handle != kNullHandle) return false;
+
+        const auto levels = snapshot.levels(entry);
+        std::uint64_t resting{};
+        for (std::size_t j = 0; j < levels.size(); ++j)
+        {
+            const SnapshotLevel& level = levels[j];
+            if (level.price <= 0 || !book.acceptsPrice(level.price)) return false;
+            if (j != 0 && j != entry.bidLevels)
+            {
+                const Price previous = levels[j - 1].price;
+                if (j < entry.bidLevels ? level.price >= previous : level.price <= previous) return false;
+            }
+            if (level.head == kNullHandle || !handleOK(level.tail, entry.carved)) return false;
+            if (!handleOK(level.head, entry.carved) || nodes[level.head].prev != kNullHandle) return false;
+            std::uint64_t quantity{};
+            OrderHandle last = kNullHandle;
+            handle = level.head;
+            for (std::uint32_t k = 0; k < level.orderCount; ++k)
+            {
+                if (handle == kNullHandle || tags[handle] != kUnseen) return false;
+                const OrderNode& node = nodes[handle];
+                if (node.prev != last || node.qty == 0 || node.id == OrderIndex::kEmpty) return false;
+                tags[handle] = levelTag(j);
+                quantity += node.qty;
+                last = handle;
+                handle = node.next;
+            }
+            if (handle != kNullHandle || last != level.tail || quantity != level.levelQTY) return false;
+            resting += level.orderCount;
+        }
+        return resting + entry.freeCount == entry.carved;
+    }
+
+    // Everything restoreSnapshot relies on that the mapping checks cannot see:
+    // the books match the engine's and are internally whole (see checkBook),
+    // and the index holds exactly one entry per resting order, naming its ID,
+    // book, side and price, with enough empty slots that probing terminates.
+    bool compatible(const MappedSnapshot& snapshot, std::span<const OrderBook> books)
+    {
+        const auto table = snapshot.books();
+        if (table.size() != books.size()) return false;
+        std::vector<std::vector<std::uint32_t>> tags(books.size());
+        std::uint64_t resting{};
+        for (std::size_t i = 0; i < books.size(); ++i)
+        {
+            const SnapshotBook& entry = table[i];
+            const auto band = books[i].band();
+            if ((entry.isLadder != 0) != band.has_value()) return false;
+            if (band && (entry.minPrice != band->minPrice || entry.maxPrice != band->maxPrice)) return false;
+            if (!checkBook(snapshot, entry, books[i], tags[i])) return false;
+            resting += entry.carved - entry.freeCount;
+        }
+
+        const auto slots = snapshot.indexSlots();
+        if (!slots.empty() && !std::has_single_bit(slots.size())) return false;
+        const std::uint64_t indexSize = snapshot.header().indexSize;
+        if (indexSize != resting || indexSize * 2 > slots.size()) return false;
+        std::uint64_t occupied{};
+        for (const IndexEntry& slot : slots)
+        {
+            if (slot.id == OrderIndex::kEmpty) continue;
+            ++occupied;
+            if (slot.symbol >= table.size()) return false;
+            const SnapshotBook& entry = table[slot.symbol];
+            const OrderHandle handle = slot.location.handle;
+            if (handle >= entry.carved) return false;
+            std::uint32_t& tag = tags[slot.symbol][handle];
+            if (tag == kUnseen || tag == kFreeSlot || tag == kIndexed) return false;
+            const std::size_t j = tag - 2;
+            const OrderSide side = j < entry.bidLevels ? OrderSide::Bid : OrderSide::Ask;
+            if (slot.location.side() != side || slot.location.price() != snapshot.levels(entry)[j].price) return false;
+            if (snapshot.nodes(entry)[handle].id != slot.id) return false;
+            tag = kIndexed;
+        }
+        return occupied == indexSize;
+    }
+    }
+
+    bool writeSnapshot(const char* path, const char* tmpPath, const SnapshotState& state)
+    {
+        const int fd = ::open(tmpPath, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) return false;
+
+        SnapshotHeader header{};
+        std::memcpy(header.magic, kMagic, sizeof(kMagic));
+        header.version = kVersion;
+        header.bookCount = static_cast<std::uint32_t>(state.books.size());
+        header.tradeID = state.tradeID;
+        header.commandSequence = state.commandSequence;
+        header.nextOrderID = state.nextOrderID;
+        header.booksOffset = alignUp(sizeof(SnapshotHeader));
+        std::uint64_t offset = alignUp(header.booksOffset + state.books.size() * sizeof(SnapshotBook));
+        for (const OrderBook& book : state.books) describe(book, offset);
+        header.indexOffset = offset;
+        header.indexSlots = state.index.slots().size();
+        header.indexSize = state.index.size();
+        header.fileBytes = header.indexOffset + header.indexSlots * sizeof(IndexEntry);
+
+        FileWriter out(fd);
+        out.put(header);
+        out.padTo(header.booksOffset);
+        offset = alignUp(header.booksOffset + state.books.size() * sizeof(SnapshotBook));
+        for (const OrderBook& book : state.books) out.put(describe(book, offset));
+        offset = alignUp(header.booksOffset + state.books.size() * sizeof(SnapshotBook));
+        for (const OrderBook& book : state.books)
+        {
+            const SnapshotBook entry = describe(book, offset);
+            out.padTo(entry.levelsOffset);
+            putLevels(out, book.m_BidSide);
+            putLevels(out, book.m_AskSide);
+            out.padTo(entry.nodesOffset);
+            putNodes(out, book.m_pool);
+        }
+        out.padTo(header.indexOffset);
+        out.put(state.index.slots().data(), state.index.slots().size_bytes());
+
+        const bool ok = out.finish();
+        ::close(fd);
+        if (!ok || ::rename(tmpPath, path) != 0)
+        {
+            ::unlink(tmpPath);
+            return false;
+        }
+        return true;
+    }
+
+    bool SnapshotJob::wait()
+    {
+        if (!started()) return false;
+        int status = 0;
+        while (::waitpid(m_pid, &status, 0) < 0)
+        {
+            if (errno != EINTR) return false;
+        }
+        m_pid = -1;
+        return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    }
+
+    // The child must not run atexit handlers or flush the parent's stdio
+    // buffers, hence _exit.
+    SnapshotJob forkSnapshot(const std::string& path, const SnapshotState& state)
+    {
+        const std::string tmpPath = path + ".tmp";
+        const pid_t pid = ::fork();
+        if (pid == 0) ::_exit(writeSnapshot(path.c_str(), tmpPath.c_str(), state) ? 0 : 1);
+        return SnapshotJob{pid};
+    }
+
+    MappedSnapshot::MappedSnapshot(const std::string& path)
+    {
+        const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return;
+        struct stat info{};
+        if (::fstat(fd, &info) == 0 && static_cast<std::size_t>(info.st_size) >= sizeof(SnapshotHeader))
+        {
+            m_bytes = static_cast<std::size_t>(info.st_size);
+            void* mapped = ::mmap(nullptr, m_bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped != MAP_FAILED) m_base = static_cast<const std::byte*>(mapped);
+        }
+        ::close(fd);
+        if (m_base != nullptr && !check())
+        {
+            ::munmap(const_cast<std::byte*>(m_base), m_bytes);
+            m_base = nullptr;
+        }
+    }
+
+    MappedSnapshot::~MappedSnapshot()
+    {
+        if (m_base != nullptr) ::munmap(const_cast<std::byte*>(m_base), m_bytes);
+    }
+
+    bool MappedSnapshot::inFile(std::uint64_t offset, std::uint64_t count, std::size_t size) const
+    {
+        return offset % kAlign == 0 && offset <= m_bytes && count <= (m_bytes - offset) / size;
+    }
+
+    bool MappedSnapshot::check() const
+    {
+        const SnapshotHeader& found = header();
+        if (std::memcmp(found.magic, kMagic, sizeof(kMagic)) != 0 || found.version != kVersion) return false;
+        if (found.fileBytes != m_bytes) return false;
+        if (!inFile(found.booksOffset, found.bookCount, sizeof(SnapshotBook))) return false;
+        for (const SnapshotBook& book : books())
+        {
+            if (!inFile(book.levelsOffset, std::uint64_t{book.bidLevels} + book.askLevels, sizeof(SnapshotLevel))) return false;
+            if (!inFile(book.nodesOffset, book.carved, sizeof(OrderNode)) || book.carved > kNullHandle) return false;
+        }
+        return inFile(found.indexOffset, found.indexSlots, sizeof(IndexEntry));
+    }
+
+    bool restoreSnapshot(const MappedSnapshot& snapshot, std::span<OrderBook> books, OrderIndex& index)
+    {
+        for (OrderBook& book : books) book.reset();
+        index.clear();
+        if (!snapshot.valid() || !compatible(snapshot, books)) return false;
+
+        const auto table = snapshot.books();
+        for (std::size_t i = 0; i < books.size(); ++i)
+        {
+            const SnapshotBook& entry = table[i];
+            OrderBook& book = books[i];
+            book.m_pool.restore(snapshot.nodes(entry), entry.freeHead, static_cast<std::size_t>(entry.freeCount));
+            const auto levels = snapshot.levels(entry);
+            for (std::size_t j = 0; j < levels.size(); ++j)
+            {
+                const SnapshotLevel& level = levels[j];
+                const OrderQueue orders{level.head, level.tail, level.orderCount};
+                if (j < entry.bidLevels) book.m_BidSide.restoreLevel(level.price, orders, level.levelQTY);
+                else book.m_AskSide.restoreLevel(level.price, orders, level.levelQTY);
+            }
+        }
+        index.restore(snapshot.indexSlots(), static_cast<std::size_t>(snapshot.header().indexSize));
+        return true;
+    }
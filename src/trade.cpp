@@ -1,23 +1,60 @@
 #include "trade.hpp"
+#include <algorithm>
+#include <bit>
 #include <iostream>
 
-
+    TradeLog::TradeLog(std::size_t capacity, std::pmr::memory_resource* resource)
+    : tradelog(std::bit_ceil(std::max<std::size_t>(capacity, 1)), resource)
+    , m_mask{tradelog.size() - 1}
+    {}
 
     void TradeLog::record(const Trade& trade) 
     {
-        tradelog.push_back(trade);
+        tradelog[m_next & m_mask] = trade;
+        ++m_next;
+    }
+
+    void TradeLog::clear()
+    {
+        m_next = 0;
+    }
+
+    const Trade* TradeLog::find(std::uint64_t sequence) const
+    {
+        if (sequence >= m_next || sequence < oldestSequence()) return nullptr;
+        return &tradelog[sequence & m_mask];
+    }
+
+    // At most two contiguous copies: up to the end of the ring, then from its start.
+    TradeRead TradeLog::read(std::uint64_t sequence, std::span<Trade> out) const
+    {
+        TradeRead result;
+        const std::uint64_t oldest = oldestSequence();
+        if (sequence < oldest)
+        {
+            result.overwritten = oldest - sequence;
+            sequence = oldest;
+        }
+        const std::uint64_t available = m_next > sequence ? m_next - sequence : 0;
+        result.count = static_cast<std::size_t>(std::min<std::uint64_t>(available, out.size()));
+        const std::size_t start = static_cast<std::size_t>(sequence & m_mask);
+        const std::size_t first = std::min(result.count, tradelog.size() - start);
+        std::copy_n(tradelog.begin() + static_cast<std::ptrdiff_t>(start), first, out.begin());
+        std::copy_n(tradelog.begin(), result.count - first, out.begin() + static_cast<std::ptrdiff_t>(first));
+        result.next = sequence + result.count;
+        return result;
     }
 
-    void TradeLog::printTrade(std::size_t index) const
+    void TradeLog::printTrade(std::size_t index, const TradeClock& clock) const
     {
-        if (index >= tradelog.size())
+        const Trade* trade = find(index);
+        if (trade == nullptr)
         {
             std::cout<<"Invalid Index \n";
             return;
         }
-        const Trade& t {tradelog[index]};
-        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
-        t.m_Time.time_since_epoch()).count();
+        const Trade& t {*trade};
+        const auto ns = clock.toNanos(t.m_Time, t.m_TimeSource);
         std::cout
         << "Trade ID: "<<t.m_TradeID
         << " Price: "<<t.m_Price
@@ -30,6 +67,5 @@
 
     std::size_t TradeLog::getTradeLogSize() const 
     {
-        return tradelog.size(); 
+        return static_cast<std::size_t>(m_next); 
     }
-    
@@ -0,0 +1,47 @@
+#include "trade_clock.hpp"
+#include "cycle_counter.hpp"
+#include <chrono>
+
+    namespace
+    {
+    std::int64_t systemNanos()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+    }
+
+    TradeClock::TradeClock()
+    : TradeClock(TimestampSource::Counter)
+    {}
+
+    TradeClock::TradeClock(TimestampSource source)
+    : m_source{source}
+    , m_anchorTicks{readCounter()}
+    , m_anchorNs{systemNanos()}
+    {
+        calibrateCounter();
+    }
+
+    void TradeClock::setSource(TimestampSource source)
+    {
+        m_source = source;
+    }
+
+    std::uint64_t TradeClock::stamp() const
+    {
+        switch (m_source)
+        {
+        case TimestampSource::Counter: return readCounter();
+        case TimestampSource::System: return static_cast<std::uint64_t>(systemNanos());
+        case TimestampSource::Virtual: return m_virtualNs;
+        }
+        return 0;
+    }
+
+    std::int64_t TradeClock::toNanos(std::uint64_t stamp, TimestampSource source) const
+    {
+        if (source != TimestampSource::Counter) return static_cast<std::int64_t>(stamp);
+        const auto elapsedTicks = static_cast<double>(static_cast<std::int64_t>(stamp - m_anchorTicks));
+        return m_anchorNs + static_cast<std::int64_t>(elapsedTicks / ticksPerNs());
+    }
@@ -0,0 +1,19 @@
+#include "trade_journal.hpp"
+#include "async_journal_impl.hpp"
+
+    JournalRecord TradeCodec::encode(const Trade& trade, std::uint64_t) const
+    {
+        JournalRecord record;
+        record.tradeID = trade.m_TradeID;
+        record.timeNs = clock.toNanos(trade.m_Time, trade.m_TimeSource);
+        record.symbol = trade.m_symbol;
+        record.price = trade.m_Price;
+        record.qty = trade.m_Qty;
+        record.aggressorID = trade.m_AggressorOrderID;
+        record.restingID = trade.m_RestingOrderID;
+        record.aggressorSide = trade.m_AggressorSide == OrderSide::Bid ? 0 : 1;
+        return record;
+    }
+
+    template class AsyncJournal<TradeCodec>;
+    template class BasicJournalReader<TradeCodec>;
@@ -0,0 +1,72 @@
+#include <gtest/gtest.h>
+#include "matching_engine.hpp"
+#include "order.hpp"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <random>
+#include <span>
+#include <vector>
+
+// Tests that assert engine work never reaches the heap. They live in their own
+// binary because counting_new.cpp replaces the global allocator for all of it.
+
+extern std::atomic<std::size_t> g_heapAllocations;   // counting_new.cpp
+
+static OrderID nextID() { return OrderIDGenerator::next(); }
+
+TEST(FixedCapacityTest, NoHeapAllocationAfterConstruction)
+{
+    EngineLimits limits;
+    limits.maxSymbols = 8;
+    limits.maxOrdersPerBook = 2000;
+    limits.maxOrders = 8000;
+    limits.band = PriceBand{1, 1000};
+    limits.maxTrades = 100'000;
+    limits.hugePages = true; // falls back to normal pages when none are reserved
+    MatchingEngine engine(limits);
+    std::mt19937 rng(5);
+    std::vector<OrderID> ids(20'000);
+    for (auto& id : ids) id = nextID();
+
+    const std::size_t before = g_heapAllocations.load();
+    for (std::size_t i = 0; i < ids.size(); ++i)
+    {
+        const auto ticker = static_cast<SymbolID>(rng() % 8);
+        const auto side = rng() % 2 ? OrderSide::Bid : OrderSide::Ask;
+        const Price price = static_cast<Price>(480 + rng() % 40);
+        switch (rng() % 4)
+        {
+        case 0: engine.submitMarketOrder(ticker, side, 5, ids[i]); break;
+        case 1: engine.cancelOrder(ids[rng() % (i + 1)]); break;
+        default: engine.submitLimitOrder(ticker, side, static_cast<Quantity>(1 + rng() % 9), ids[i], price); break;
+        }
+    }
+    EXPECT_EQ(g_heapAllocations.load(), before);
+    EXPECT_GT(engine.getLogSize(), 0u);
+}
+
+TEST(DepthQueryTest, QueriesNeverAllocate)
+{
+    MatchingEngine mapBooks(2);
+    MatchingEngine ladderBooks(2, PriceBand{1, 200});
+    for (Price price = 90; price < 110; ++price)
+    {
+        mapBooks.submitLimitOrder(1, price < 100 ? OrderSide::Bid : OrderSide::Ask, 3, nextID(), price);
+        ladderBooks.submitLimitOrder(1, price < 100 ? OrderSide::Bid : OrderSide::Ask, 3, nextID(), price);
+    }
+    std::vector<Price> bidPrices(20), askPrices(20);
+    std::vector<Quantity> bidQuantities(20), askQuantities(20);
+    const DepthBuffer buffer{bidPrices, bidQuantities, askPrices, askQuantities};
+    std::array<DepthBuffer, 2> out{buffer, buffer};
+    const std::array<SymbolID, 2> tickers{1, 0};
+
+    const std::size_t before = g_heapAllocations.load();
+    mapBooks.depth(tickers, 20, out);
+    EXPECT_EQ(out[0].bids, 10u);
+    ladderBooks.depth(tickers, 20, out);
+    EXPECT_EQ(out[0].asks, 10u);
+    EXPECT_EQ(out[1].asks, 0u);
+    EXPECT_EQ(g_heapAllocations.load(), before);
+}
+
@@ -0,0 +1,55 @@
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+// Replaces every global allocation function in the allocation test binary and
+// counts each call, so a test can assert that a stretch of engine work never
+// reached the heap. Kept in its own translation unit so the compiler cannot
+// inline malloc into the callers and then flag their deletes as mismatched.
+std::atomic<std::size_t> g_heapAllocations{0};
+
+namespace
+{
+void* allocate(std::size_t bytes)
+{
+    ++g_heapAllocations;
+    return std::malloc(bytes == 0 ? 1 : bytes);
+}
+
+void* allocate(std::size_t bytes, std::align_val_t alignment)
+{
+    ++g_heapAllocations;
+    const auto align = static_cast<std::size_t>(alignment);
+    // aligned_alloc wants the size to be a multiple of the alignment.
+    return std::aligned_alloc(align, (bytes + align - 1) / align * align);
+}
+
+void* orThrow(void* p)
+{
+    if (p == nullptr) throw std::bad_alloc{};
+    return p;
+}
+}
+
+void* operator new(std::size_t bytes) { return orThrow(allocate(bytes)); }
+void* operator new[](std::size_t bytes) { return orThrow(allocate(bytes)); }
+void* operator new(std::size_t bytes, const std::nothrow_t&) noexcept { return allocate(bytes); }
+void* operator new[](std::size_t bytes, const std::nothrow_t&) noexcept { return allocate(bytes); }
+void* operator new(std::size_t bytes, std::align_val_t align) { return orThrow(allocate(bytes, align)); }
+void* operator new[](std::size_t bytes, std::align_val_t align) { return orThrow(allocate(bytes, align)); }
+void* operator new(std::size_t bytes, std::align_val_t align, const std::nothrow_t&) noexcept { return allocate(bytes, align); }
+void* operator new[](std::size_t bytes, std::align_val_t align, const std::nothrow_t&) noexcept { return allocate(bytes, align); }
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { std::free(p); }
@@ -1,6 +1,37 @@
 #include <gtest/gtest.h>
+#include "command_log.hpp"
+#include "fenwick_tree.hpp"
+#include "journal_file.hpp"
+#include "level_bitmap.hpp"
 #include "matching_engine.hpp"
+#include "matching_engine_impl.hpp"
+#include "mpsc_ring.hpp"
 #include "order.hpp"
+#include "order_index.hpp"
+#include "sharded_engine.hpp"
+#include "snapshot.hpp"
+#include "spsc_ring.hpp"
+#include "trade_clock.hpp"
+#include "trade_journal.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <memory_resource>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 
 static OrderID nextID() { return OrderIDGenerator::next(); }
@@ -1316,3 +1347,2588 @@ TEST(FOKAskTest, DoesNotRestAfterKill)
     EXPECT_FALSE(engine.hasAsk(kTicker));
     EXPECT_FALSE(engine.bestAsk(kTicker).has_value());
 }
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Order Pool Tests
+// ─────────────────────────────────────────────────────────────────────────────
+
+TEST(OrderPoolTest, FilledOrderReturnsSlotToPool)
+{
+    MatchingEngine engine;
+    engine.submitLimitOrder(kTicker, OrderSide::Ask, 10, nextID(), 100);
+    const std::size_t resting = engine.book[kTicker].m_pool.available();
+
+    engine.submitMarketOrder(kTicker, OrderSide::Bid, 10, nextID());
+    EXPECT_EQ(engine.book[kTicker].m_pool.available(), resting + 1);
+}
+
+TEST(OrderPoolTest, CancelledOrderReturnsSlotToPool)
+{
+    MatchingEngine engine;
+    OrderID id = nextID();
+    engine.submitLimitOrder(kTicker, OrderSide::Bid, 10, id, 100);
+    const std::size_t resting = engine.book[kTicker].m_pool.available();
+
+    ASSERT_TRUE(engine.cancelOrder(id));
+    EXPECT_EQ(engine.book[kTicker].m_pool.available(), resting + 1);
+}
+
+TEST(OrderPoolTest, RecycledSlotCarriesNewOrder)
+{
+    // The second order reuses the first one's slot; it must match with its own
+    // quantity and price rather than anything left over from the recycled slot.
+    MatchingEngine engine;
+    OrderID first = nextID();
+    engine.submitLimitOrder(kTicker, OrderSide::Bid, 10, first, 100);
+    ASSERT_TRUE(engine.cancelOrder(first));
+
+    engine.submitLimitOrder(kTicker, OrderSide::Bid, 4, nextID(), 95);
+    EXPECT_EQ(engine.bestBid(kTicker).value(), 95);
+
+    engine.submitMarketOrder(kTicker, OrderSide::Ask, 10, nextID());
+    EXPECT_EQ(engine.getLogSize(), 1u);
+    EXPECT_FALSE(engine.hasBid(kTicker));
+}
+
+TEST(OrderPoolTest, ReserveOrdersPrefillsPool)
+{
+    MatchingEngine engine;
+    engine.book[kTicker].reserveOrders(2000);
+    const std::size_t reserved = engine.book[kTicker].m_pool.available();
+    EXPECT_GE(reserved, 2000u);
+
+    engine.submitLimitOrder(kTicker, OrderSide::Ask, 10, nextID(), 100);
+    EXPECT_EQ(engine.book[kTicker].m_pool.available(), reserved - 1);
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Intrusive Queue Tests
+// ─────────────────────────────────────────────────────────────────────────────
+
+TEST(OrderQueueTest, CancelHeadAndTailKeepsMiddleMatchable)
+{
+    MatchingEngine engine;
+    OrderID first  = nextID();
+    OrderID middle = nextID();
+    OrderID last   = nextID();
+    engine.submitLimitOrder(kTicker, OrderSide::Ask, 10, first,  100);
+    engine.submitLimitOrder(kTicker, OrderSide::Ask,  7, middle, 100);
+    engine.submitLimitOrder(kTicker, OrderSide::Ask, 10, last,   100);
+    ASSERT_TRUE(engine.cancelOrder(first));
+    ASSERT_TRUE(engine.cancelOrder(last));
+
+    engine.submitMarketOrder(kTicker, OrderSide::Bid, 20, nextID());
+    EXPECT_EQ(engine.getLogSize(), 1u); // only the middle order was left
+    EXPECT_FALSE(engine.hasAsk(kTicker));
+}
+
+TEST(OrderQueueTest, CancelAfterPartialFillRemovesLevel)
+{
+    // The level must go away once its last order is cancelled, even when that
+    // order was partially filled first.
+    MatchingEngine engine;
+    OrderID id = nextID();
+    engine.submitLimitOrder(kTicker, OrderSide::Bid, 10, id, 101);
+    engine.submitLimitOrder(kTicker, OrderSide::Bid, 10, nextID(), 100);
+    engine.submitMarketOrder(kTicker, OrderSide::Ask, 4, nextID());
+    ASSERT_TRUE(engine.cancelOrder(id));
+
+    ASSERT_TRUE(engine.bestBid(kTicker).has_value());
+    EXPECT_EQ(engine.bestBid(kTicker).value(), 100);
+    engine.submitMarketOrder(kTicker, OrderSide::Ask, 10, nextID());
+    EXPECT_EQ(engine.getLogSize(), 2u);
+    EXPECT_FALSE(engine.hasBid(kTicker));
+}
+
+TEST(OrderQueueTest, FOKSeesLevelQuantityAfterPartialFill)
+{
+    // 10 rest, 6 are filled: a FOK for 5 must be killed, not partially filled.
+    MatchingEngine engine;
+    engine.submitLimitOrder(kTicker, OrderSide::Ask, 10, nextID(), 100);
+    engine.submitMarketOrder(kTicker, OrderSide::Bid, 6, nextID());
+    engine.submitLimitOrder(kTicker, OrderSide::Bid, 5, nextID(), 100, LimitType::FOK);
+
+    EXPECT_EQ(engine.getLogSize(), 1u);
+    EXPECT_TRUE(engine.hasAsk(kTicker));
+}
+
+TEST(OrderQueueTest, FOKSeesLevelQuantityAfterReduce)
+{
+    MatchingEngine engine;
+    OrderID id = nextID();
+    engine.submitLimitOrder(kTicker, OrderSide::Bid, 10, id, 100);
+    ASSERT_TRUE(engine.reduceOrder(id, 3));
+    engine.submitLimitOrder(kTicker, OrderSide::Ask, 5, nextID(), 100, LimitType::FOK);
+
+    EXPECT_EQ(engine.getLogSize(), 0u);
+    EXPECT_TRUE(engine.hasBid(kTicker));
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Price Ladder Tests
+// ─────────────────────────────────────────────────────────────────────────────
+
+// Single-symbol engine whose book is a ladder over ticks 1..300.
+static MatchingEngine ladderEngine() { return MatchingEngine(1, PriceBand{1, 300}); }
+
+TEST(PriceLadderTest, BestPricesTrackInsertions)
+{
+    MatchingEngine engine = ladderEngine();
+    ASSERT_TRUE(engine.book[kTicker].isLadder());
+    engine.submitLimitOrder(kTicker, OrderSide::Bid, 10, nextID(),  99);
+    engine.submitLimitOrder(kTicker, OrderSide::Bid, 10, nextID(), 101);
+    engine.submitLimitOrder(kTicker, OrderSide::Ask, 10, nextID(), 110);
+    engine.submitLimitOrder(kTicker, OrderSide::Ask, 10, nextID(), 105);
+
+    EXPECT_EQ(engine.bestBid(kTicker).value(), 101);
+    EXPECT_EQ(engine.bestAsk(kTicker).value(), 105);
+    EXPECT_EQ(engine.getLogSize(), 0u);
+}
+
+TEST(PriceLadderTest, FillingBestLevelPromotesNextLevel)
+{
+    MatchingEngine engine = ladderEngine();
+    engine.submitLimitOrder(kTicker, OrderSide::Ask, 5, nextID(), 100);
+    engine.submitLimitOrder(kTicker, OrderSide::Ask, 5, nextID(), 140);
+    engine.submitMarketOrder(kTicker, OrderSide::Bid, 5, nextID());
+
+    ASSERT_TRUE(engine.bestAsk(kTicker).has_value());
+    EXPECT_EQ(engine.bestAsk(kTicker).value(), 140);
+}
+
+TEST(PriceLadderTest, CancelBestBidPromotesNextLevel)
+{
+    MatchingEngine engine = ladderEngine();
+    OrderID best = nextID();
+    engine.submitLimitOrder(kTicker, OrderSide::Bid, 10, nextID(), 20);
+    engine.submitLimitOrder(kTicker, OrderSide::Bid, 10, best, 250);
+    ASSERT_TRUE(engine.cancelOrder(best));
+
+    EXPECT_EQ(engine.bestBid(kTicker).value(), 20);
+}
+
+TEST(PriceLadderTest, CancelLastOrderEmptiesSide)
+{
+    MatchingEngine engine = ladderEngine();
+    OrderID id = nextID();
+    engine.submitLimitOrder(kTicker, OrderSide::Ask, 10, id, 300);
+    ASSERT_TRUE(engine.cancelOrder(id));
+
+    EXPECT_FALSE(engine.hasAsk(kTicker));
+    EXPECT_FALSE(engine.bestAsk(kTicker).has_value());
+}
+
+TEST(PriceLadderTest, SweepAcrossLevelsMatchesMapBook)
+{
+    MatchingEngine engine = ladderEngine();
+    engine.submitLimitOrder(kTicker, OrderSide::Bid, 5, nextID(), 101);
+    engine.submitLimitOrder(kTicker, OrderSide::Bid, 5, nextID(), 100);
+    engine.submitLimitOrder(kTicker, OrderSide::Bid, 5, nextID(),  90);
+    engine.submitLimitOrder(kTicker, OrderSide::Ask, 12, nextID(), 95);
+
+    EXPECT_EQ(engine.getLogSize(), 2u);
+    EXPECT_EQ(engine.bestBid(kTicker).value(), 90);
+    EXPECT_EQ(engine.bestAsk(kTicker).value(), 95); // remainder of 2 rests
+}
+
+TEST(PriceLadderTest, FOKChecksVolumeAcrossLadder)
+{
+    MatchingEngine engine = ladderEngine();
+    engine.submitLimitOrder(kTicker, OrderSide::Ask, 5, nextID(), 100);
+    engine.submitLimitOrder(kTicker, OrderSide::Ask, 5, nextID(), 102);
+    engine.submitLimitOrder(kTicker, OrderSide::Bid, 10, nextID(), 101, LimitType::FOK);
+    EXPECT_EQ(engine.getLogSize(), 0u);
+
+    engine.submitLimitOrder(kTicker, OrderSide::Bid, 10, nextID(), 102, LimitType::FOK);
+    EXPECT_EQ(engine.getLogSize(), 2u);
+    EXPECT_FALSE(engine.hasAsk(kTicker));
+}
+
+TEST(PriceLadderTest, PriceOutsideBandRejected)
+{
+    MatchingEngine engine = ladderEngine();
+    engine.submitLimitOrder(kTicker, OrderSide::Bid, 10, nextID(), 301);
+    engine.submitLimitOrder(kTicker, OrderSide::Ask, 10, nextID(), 1000);
+
+    EXPECT_FALSE(engine.hasBid(kTicker));
+    EXPECT_FALSE(engine.hasAsk(kTicker));
+}
+
+TEST(PriceLadderTest, ConfigureBookOnlyWhenEmpty)
+{
+    MatchingEngine engine(2);
+    engine.submitLimitOrder(1, OrderSide::Bid, 10, nextID(), 100);
+
+    EXPECT_TRUE(engine.configureBook(0, PriceBand{50, 150}));
+    EXPECT_FALSE(engine.configureBook(1, PriceBand{50, 150}));
+    EXPECT_TRUE(engine.book[0].isLadder());
+    EXPECT_FALSE(engine.book[1].isLadder());
+}
+
+TEST(PriceLadderTest, EveryConstructorRejectsABadBand)
+{
+    for (const PriceBand band : {PriceBand{100, 1}, PriceBand{0, 300}, PriceBand{-5, 300}, PriceBand{}})
+    {
+        EXPECT_THROW(BookSide<std::greater<Price>>{band}, std::invalid_argument);
+        EXPECT_THROW(OrderBook{band}, std::invalid_argument);
+        EXPECT_THROW(MatchingEngine(2, band), std::invalid_argument);
+
+        MatchingEngine engine(1);
+        EXPECT_FALSE(engine.configureBook(0, band));
+        EXPECT_FALSE(engine.book[0].isLadder());
+    }
+    const PriceBand oneTick{7, 7};
+    EXPECT_NO_THROW(OrderBook{oneTick});
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Level Bitmap Tests
+// ─────────────────────────────────────────────────────────────────────────────
+
+TEST(LevelBitmapTest, EmptyBitmapFindsNothing)
+{
+    LevelBitmap bits(300'000);
+    EXPECT_EQ(bits.nextSet(0), LevelBitmap::npos);
+    EXPECT_EQ(bits.prevSet(299'999), LevelBitmap::npos);
+}
+
+TEST(LevelBitmapTest, FindsNeighboursAcrossAllTiers)
+{
+    // 300k indices need three tiers; 5 and 299'000 are words and tier-1 words apart.
+    LevelBitmap bits(300'000);
+    bits.set(5);
+    bits.set(299'000);
+
+    EXPECT_EQ(bits.nextSet(0), 5u);
+    EXPECT_EQ(bits.nextSet(5), 5u);
+    EXPECT_EQ(bits.nextSet(6), 299'000u);
+    EXPECT_EQ(bits.nextSet(299'001), LevelBitmap::npos);
+    EXPECT_EQ(bits.prevSet(299'999), 299'000u);
+    EXPECT_EQ(bits.prevSet(298'999), 5u);
+    EXPECT_EQ(bits.prevSet(4), LevelBitmap::npos);
+}
+
+TEST(LevelBitmapTest, ClearOnlyDropsSummaryWhenWordEmpties)
+{
+    LevelBitmap bits(10'000);
+    bits.set(4'096);
+    bits.set(4'097);
+    bits.clear(4'096);
+    EXPECT_EQ(bits.nextSet(0), 4'097u);
+    EXPECT_FALSE(bits.test(4'096));
+
+    bits.clear(4'097);
+    EXPECT_EQ(bits.nextSet(0), LevelBitmap::npos);
+    EXPECT_EQ(bits.prevSet(9'999), LevelBitmap::npos);
+}
+
+TEST(LevelBitmapTest, SparseWideLadderSweepFindsNextLevels)
+{
+    // Levels far apart in a wide band: a market order sweeping the best ask has
+    // to land on the next occupied tick, not scan to it.
+    MatchingEngine engine(1, PriceBand{1, 250'000});
+    engine.submitLimitOrder(kTicker, OrderSide::Ask, 5, nextID(), 10);
+    engine.submitLimitOrder(kTicker, OrderSide::Ask, 5, nextID(), 70'000);
+    engine.submitLimitOrder(kTicker, OrderSide::Ask, 5, nextID(), 249'999);
+    engine.submitLimitOrder(kTicker, OrderSide::Bid, 5, nextID(), 9);
+    engine.submitLimitOrder(kTicker, OrderSide::Bid, 5, nextID(), 1);
+
+    engine.submitMarketOrder(kTicker, OrderSide::Bid, 5, nextID());
+    EXPECT_EQ(engine.bestAsk(kTicker).value(), 70'000);
+    engine.submitMarketOrder(kTicker, OrderSide::Bid, 5, nextID());
+    EXPECT_EQ(engine.bestAsk(kTicker).value(), 249'999);
+    engine.submitMarketOrder(kTicker, OrderSide::Ask, 5, nextID());
+    EXPECT_EQ(engine.bestBid(kTicker).value(), 1);
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Order Index Tests
+// ─────────────────────────────────────────────────────────────────────────────
+
+TEST(OrderIndexTest, InsertFindErase)
+{
+    OrderIndex index;
+    index.insert(42, 3, LookUp{OrderSide::Ask, 7, 105});
+
+    IndexEntry* entry = index.find(42);
+    ASSERT_NE(entry, nullptr);
+    EXPECT_EQ(entry->symbol, 3u);
+    EXPECT_EQ(entry->location.side(), OrderSide::Ask);
+    EXPECT_EQ(entry->location.handle, 7u);
+    EXPECT_EQ(entry->location.price(), 105);
+
+    EXPECT_TRUE(index.erase(42));
+    EXPECT_EQ(index.find(42), nullptr);
+    EXPECT_FALSE(index.erase(42));
+    EXPECT_EQ(index.size(), 0u);
+}
+
+TEST(OrderIndexTest, PackedLookUpKeepsSideAndFullPriceRange)
+{
+    const Price top = std::numeric_limits<Price>::max();
+    const LookUp bid{OrderSide::Bid, 1, top};
+    const LookUp ask{OrderSide::Ask, kNullHandle - 1, 1};
+    EXPECT_EQ(bid.side(), OrderSide::Bid);
+    EXPECT_EQ(bid.price(), top);
+    EXPECT_EQ(ask.side(), OrderSide::Ask);
+    EXPECT_EQ(ask.price(), 1);
+    EXPECT_EQ(ask.handle, kNullHandle - 1);
+}
+
+TEST(OrderIndexTest, MapBookRestsAndCancelsAtHighPrice)
+{
+    MatchingEngine engine;
+    const Price high = std::numeric_limits<Price>::max() - 1;
+    OrderID id = nextID();
+    engine.submitLimitOrder(kTicker, OrderSide::Ask, 5, id, high);
+    EXPECT_EQ(engine.bestAsk(kTicker), high);
+    EXPECT_TRUE(engine.reduceOrder(id, 2));
+    engine.submitMarketOrder(kTicker, OrderSide::Bid, 1, nextID());
+    EXPECT_EQ(engine.book[kTicker].restingQuantity(engine.orderIndex.find(id)->location), 1u);
+    EXPECT_TRUE(engine.cancelOrder(id));
+    EXPECT_FALSE(engine.hasAsk(kTicker));
+}
+
+TEST(OrderIndexTest, ReserveAvoidsGrowth)
+{
+    OrderIndex index;
+    index.reserve(1000);
+    const std::size_t capacity = index.capacity();
+    for (OrderID id = 1; id <= 1000; ++id) index.insert(id, 0, LookUp{});
+    EXPECT_EQ(index.capacity(), capacity);
+    EXPECT_EQ(index.size(), 1000u);
+}
+
+TEST(OrderIndexTest, RandomChurnMatchesUnorderedMap)
+{
+    // Backward-shift deletion must leave every surviving key reachable.
+    OrderIndex index;
+    std::unordered_map<OrderID, std::uint32_t> reference;
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<OrderID> ids(1, 4000);
+    for (int i = 0; i < 200'000; ++i)
+    {
+        const OrderID id = ids(rng);
+        if (rng() % 2)
+        {
+            const auto symbol = static_cast<std::uint32_t>(rng() % 200);
+            EXPECT_EQ(index.insert(id, symbol, LookUp{}), reference.emplace(id, symbol).second);
+        }
+        else
+        {
+            EXPECT_EQ(index.erase(id), reference.erase(id) == 1);
+        }
+    }
+    ASSERT_EQ(index.size(), reference.size());
+    for (const auto& [id, symbol] : reference)
+    {
+        const IndexEntry* entry = index.find(id);
+        ASSERT_NE(entry, nullptr);
+        EXPECT_EQ(entry->symbol, symbol);
+    }
+}
+
+TEST(OrderIndexTest, FilledOrdersLeaveIndex)
+{
+    MatchingEngine engine;
+    engine.submitLimitOrder(kTicker, OrderSide::Ask, 5, nextID(), 100);
+    engine.submitLimitOrder(kTicker, OrderSide::Ask, 5, nextID(), 101);
+    EXPECT_EQ(engine.orderIndex.size(), 2u);
+
+    engine.submitMarketOrder(kTicker, OrderSide::Bid, 7, nextID());
+    EXPECT_EQ(engine.orderIndex.size(), 1u); // 101 partially filled, still resting
+}
+
+TEST(OrderIndexTest, ModifiesRouteAcrossSymbols)
+{
+    MatchingEngine engine(3);
+    OrderID onTwo = nextID();
+    engine.submitLimitOrder(0, OrderSide::Bid, 10, nextID(), 100);
+    engine.submitLimitOrder(2, OrderSide::Bid, 10, onTwo, 100);
+
+    ASSERT_EQ(engine.requestModify(onTwo), SymbolID{2});
+    EXPECT_TRUE(engine.reduceOrder(onTwo, 4));
+    EXPECT_TRUE(engine.cancelOrder(onTwo));
+    EXPECT_FALSE(engine.hasBid(2));
+    EXPECT_TRUE(engine.hasBid(0));
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// SPSC Ring Tests
+// ─────────────────────────────────────────────────────────────────────────────
+
+TEST(SpscRingTest, RejectsPushWhenFullAndPreservesOrder)
+{
+    SpscRing<int> ring(4);
+    for (int i = 0; i < 4; ++i) EXPECT_TRUE(ring.tryPush(i));
+    EXPECT_FALSE(ring.tryPush(99));
+
+    int out[8];
+    ASSERT_EQ(ring.popBatch(out, 8), 4u);
+    for (int i = 0; i < 4; ++i) EXPECT_EQ(out[i], i);
+    EXPECT_FALSE(ring.tryPop(out[0]));
+}
+
+TEST(SpscRingTest, CrossThreadTransferIsLosslessAndOrdered)
+{
+    SpscRing<int> ring(64);
+    constexpr int kCount = 100'000;
+    std::thread producer([&]
+    {
+        for (int i = 0; i < kCount; ++i)
+        {
+            while (!ring.tryPush(i)) std::this_thread::yield();
+        }
+    });
+    int expected = 0;
+    while (expected < kCount)
+    {
+        int value;
+        if (!ring.tryPop(value)) { std::this_thread::yield(); continue; }
+        ASSERT_EQ(value, expected);
+        ++expected;
+    }
+    producer.join();
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Sharded Engine Tests
+// ─────────────────────────────────────────────────────────────────────────────
+
+TEST(ShardedEngineTest, RoutesSymbolsToOwningShard)
+{
+    ShardedEngine engine(8, 3, std::nullopt, 1024, false);
+    for (SymbolID t = 0; t < 8; ++t)
+    {
+        engine.submitLimitOrder(t, OrderSide::Bid, 10, nextID(), 100 + static_cast<Price>(t));
+    }
+    engine.flush();
+
+    for (SymbolID t = 0; t < 8; ++t)
+    {
+        EXPECT_EQ(engine.engineFor(t).bestBid(engine.localTicker(t)).value(), 100 + static_cast<Price>(t));
+    }
+    // Each shard holds books for its own tickers only: 0 3 6, 1 4 7 and 2 5.
+    EXPECT_EQ(engine.shard(0).book.size(), 3u);
+    EXPECT_EQ(engine.shard(1).book.size(), 3u);
+    EXPECT_EQ(engine.shard(2).book.size(), 2u);
+    EXPECT_EQ(engine.shard(2).bestBid(1).value(), 105);
+}
+
+TEST(ShardedEngineTest, MatchesAndModifiesWithinShard)
+{
+    ShardedEngine engine(4, 2, std::nullopt, 1024, false);
+    OrderID resting = nextID();
+    engine.submitLimitOrder(1, OrderSide::Ask, 10, resting, 100);
+    engine.submitLimitOrder(1, OrderSide::Ask, 10, nextID(), 101);
+    engine.submitMarketOrder(1, OrderSide::Bid, 4, nextID());
+    engine.reduceOrder(1, resting, 2);
+    engine.cancelOrder(1, resting);
+    engine.flush();
+
+    EXPECT_EQ(engine.getLogSize(), 1u);
+    EXPECT_EQ(engine.engineFor(1).bestAsk(engine.localTicker(1)).value(), 101);
+}
+
+TEST(ShardedEngineTest, CancelReplaceIDsComeFromTheSubmittingThread)
+{
+    ShardedEngine engine(4, 4, std::nullopt, 1024, false);
+    std::vector<OrderID> ids;
+    for (SymbolID t = 0; t < 4; ++t) engine.submitLimitOrder(t, OrderSide::Bid, 5, ids.emplace_back(nextID()), 100);
+    const OrderID firstReplacement = OrderIDGenerator::peek();
+    for (int round = 0; round < 50; ++round)
+    {
+        for (SymbolID t = 0; t < 4; ++t)
+        {
+            engine.cancelReplace(t, ids[t], 5, 100 + round);
+            ids[t] = firstReplacement + static_cast<OrderID>(round * 4 + static_cast<int>(t));
+        }
+    }
+    engine.flush();
+
+    // Replacement IDs were handed out in submission order, whatever the
+    // workers' interleaving.
+    EXPECT_EQ(OrderIDGenerator::peek(), firstReplacement + 200);
+    for (SymbolID t = 0; t < 4; ++t)
+    {
+        const MatchingEngine& shard = engine.engineFor(t);
+        EXPECT_EQ(shard.orderIndex.size(), 1u);
+        EXPECT_EQ(shard.bestBid(engine.localTicker(t)).value(), 149);
+        const OrderBook& book = shard.book[engine.localTicker(t)];
+        book.m_BidSide.forEachLevel([&](Price, const PriceLevel& level)
+        {
+            EXPECT_EQ(book.m_pool[level.orders.head].id, ids[t]);
+            return false;
+        });
+    }
+}
+
+TEST(ShardedEngineTest, ShardsUseDisjointTradeIDRanges)
+{
+    ShardedEngine engine(2, 2, PriceBand{1, 300}, 1024, false);
+    for (SymbolID t = 0; t < 2; ++t)
+    {
+        engine.submitLimitOrder(t, OrderSide::Ask, 5, nextID(), 100);
+        engine.submitMarketOrder(t, OrderSide::Bid, 5, nextID());
+    }
+    engine.flush();
+
+    EXPECT_EQ(engine.shard(0).id, TradeID{1});
+    EXPECT_EQ(engine.shard(1).id, (TradeID{1} << ShardedEngine::kTradeIDShardShift) + 1);
+}
+
+TEST(ShardedEngineTest, StopDrainsQueuedCommands)
+{
+    ShardedEngine engine(2, 2, std::nullopt, 4096, false);
+    for (int i = 0; i < 2000; ++i)
+    {
+        engine.submitLimitOrder(static_cast<SymbolID>(i % 2), OrderSide::Bid, 1, nextID(), 100);
+    }
+    engine.stop();
+
+    EXPECT_EQ(engine.shard(0).orderIndex.size() + engine.shard(1).orderIndex.size(), 2000u);
+}
+
+TEST(ShardedEngineTest, ZeroShardsIsRejected)
+{
+    EXPECT_THROW(ShardedEngine(4, 0), std::invalid_argument);
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// MPSC Ingress Ring Tests
+// ─────────────────────────────────────────────────────────────────────────────
+
+TEST(MpscRingTest, FullRingRejectsAndCounts)
+{
+    MpscRing<int> ring(2);
+    EXPECT_TRUE(ring.tryPush(1));
+    EXPECT_TRUE(ring.tryPush(2));
+    EXPECT_FALSE(ring.tryPush(3));
+    EXPECT_EQ(ring.rejected(), 1u);
+
+    int value;
+    ASSERT_TRUE(ring.tryPop(value));
+    EXPECT_EQ(value, 1);
+    EXPECT_TRUE(ring.tryPush(3)); // the popped slot is reusable
+}
+
+TEST(MpscRingTest, ConcurrentProducersAreLosslessAndPerProducerOrdered)
+{
+    constexpr int kProducers = 4;
+    constexpr int kPerProducer = 20'000;
+    MpscRing<int> ring(128);
+    std::vector<std::thread> producers;
+    for (int p = 0; p < kProducers; ++p)
+    {
+        producers.emplace_back([&ring, p]
+        {
+            for (int i = 0; i < kPerProducer; ++i) ring.push(p * kPerProducer + i);
+        });
+    }
+
+    std::vector<int> next(kProducers, 0);
+    int received = 0;
+    while (received < kProducers * kPerProducer)
+    {
+        int value;
+        if (!ring.tryPop(value)) { std::this_thread::yield(); continue; }
+        const auto producer = static_cast<std::size_t>(value / kPerProducer);
+        ASSERT_EQ(value % kPerProducer, next[producer]);
+        ++next[producer];
+        ++received;
+    }
+    for (auto& producer : producers) producer.join();
+    EXPECT_EQ(ring.rejected(), 0u);
+}
+
+TEST(MpscRingTest, EngineDrainsCommandsInBatches)
+{
+    MatchingEngine engine;
+    MpscRing<Command> ingress(16);
+    OrderID resting = nextID();
+    ingress.push(Command::limit(kTicker, OrderSide::Ask, 10, resting, 100));
+    ingress.push(Command::limit(kTicker, OrderSide::Ask, 10, nextID(), 101));
+    ingress.push(Command::market(kTicker, OrderSide::Bid, 4, nextID()));
+    ingress.push(Command::cancel(resting));
+
+    EXPECT_EQ(engine.drain(ingress, 3), 3u);
+    EXPECT_EQ(engine.getLogSize(), 1u);
+    EXPECT_EQ(engine.bestAsk(kTicker).value(), 100);
+
+    EXPECT_EQ(engine.drain(ingress), 1u);
+    EXPECT_EQ(engine.bestAsk(kTicker).value(), 101);
+    EXPECT_EQ(engine.drain(ingress), 0u);
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Batch Processing Tests
+// ─────────────────────────────────────────────────────────────────────────────
+
+TEST(ProcessBatchTest, WritesResultsAndFillsInOrder)
+{
+    MatchingEngine engine;
+    OrderID askA = nextID();
+    OrderID askB = nextID();
+    OrderID bid  = nextID();
+    const Command commands[] = {
+        Command::limit(kTicker, OrderSide::Ask, 5, askA, 100),
+        Command::limit(kTicker, OrderSide::Ask, 5, askB, 101),
+        Command::limit(kTicker, OrderSide::Bid, 12, bid, 101), // sweeps both, rests 2
+        Command::cancel(askA),                                 // already filled
+    };
+    CommandResult results[4];
+    Fill fills[8];
+
+    const BatchSummary summary = engine.processBatch(commands, results, fills);
+    EXPECT_EQ(summary.commands, 4u);
+    EXPECT_EQ(summary.fills, 2u);
+    EXPECT_EQ(summary.fillsDropped, 0u);
+
+    EXPECT_EQ(results[0].restedQTY, 5u);
+    EXPECT_EQ(results[2].status, CommandStatus::Accepted);
+    EXPECT_EQ(results[2].filledQTY, 10u);
+    EXPECT_EQ(results[2].restedQTY, 2u);
+    EXPECT_EQ(results[2].firstFill, 0u);
+    EXPECT_EQ(results[2].fillCount, 2u);
+    EXPECT_EQ(results[3].status, CommandStatus::NotFound);
+
+    EXPECT_EQ(fills[0].restingID, askA);
+    EXPECT_EQ(fills[0].price, 100);
+    EXPECT_EQ(fills[1].restingID, askB);
+    EXPECT_EQ(fills[1].aggressorID, bid);
+    EXPECT_EQ(fills[1].qty, 5u);
+    EXPECT_EQ(engine.getLogSize(), 2u);
+}
+
+TEST(ProcessBatchTest, RejectsInvalidCommands)
+{
+    MatchingEngine engine;
+    OrderID id = nextID();
+    const Command commands[] = {
+        Command::limit(kTicker, OrderSide::Bid, 0, nextID(), 100),
+        Command::limit(kTicker, OrderSide::Bid, 10, nextID(), -5),
+        Command::market(kTicker, OrderSide::Ask, 0, nextID()),
+        Command::limit(kTicker, OrderSide::Bid, 10, id, 100),
+        Command::reduce(id, 20),
+        Command::reduce(nextID(), 1),
+    };
+    CommandResult results[6];
+
+    engine.processBatch(commands, results, {});
+    EXPECT_EQ(results[0].status, CommandStatus::Rejected);
+    EXPECT_EQ(results[1].status, CommandStatus::Rejected);
+    EXPECT_EQ(results[2].status, CommandStatus::Rejected);
+    EXPECT_EQ(results[3].status, CommandStatus::Accepted);
+    EXPECT_EQ(results[4].status, CommandStatus::Rejected);
+    EXPECT_EQ(results[5].status, CommandStatus::NotFound);
+}
+
+TEST(ProcessBatchTest, FullFillBufferCountsDroppedFills)
+{
+    MatchingEngine engine;
+    for (Price p = 100; p < 104; ++p) engine.submitLimitOrder(kTicker, OrderSide::Ask, 1, nextID(), p);
+    const Command commands[] = {Command::market(kTicker, OrderSide::Bid, 4, nextID())};
+    CommandResult results[1];
+    Fill fills[3];
+
+    const BatchSummary summary = engine.processBatch(commands, results, fills);
+    EXPECT_EQ(summary.fills, 3u);
+    EXPECT_EQ(summary.fillsDropped, 1u);
+    EXPECT_EQ(results[0].filledQTY, 4u);
+    EXPECT_EQ(engine.getLogSize(), 4u); // the trade log still has every fill
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Sweep Tests
+// ─────────────────────────────────────────────────────────────────────────────
+
+TEST(SweepTest, ReportsFifoAcrossLevelsAndStopsAtLimit)
+{
+    OrderBook book;
+    OrderID a = nextID(), b = nextID(), c = nextID();
+    book.addAsk(LimitOrder{OrderSide::Ask, 3, a, 100, LimitType::GTC});
+    book.addAsk(LimitOrder{OrderSide::Ask, 4, b, 100, LimitType::GTC});
+    book.addAsk(LimitOrder{OrderSide::Ask, 5, c, 102, LimitType::GTC});
+    std::array<ExecutionReport, 8> out;
+    std::size_t written{};
+
+    const Quantity left = book.sweep(OrderSide::Bid, 10, 101, out, written);
+    EXPECT_EQ(left, 3u);
+    ASSERT_EQ(written, 2u);
+    EXPECT_EQ(out[0].restingID, a);
+    EXPECT_EQ(out[0].remainingQTY, 0u);
+    EXPECT_EQ(out[1].restingID, b);
+    EXPECT_EQ(out[1].executedQTY, 4u);
+    EXPECT_EQ(book.bestAsk(), 102); // 100 emptied and erased, 102 did not cross
+}
+
+TEST(SweepTest, FullOutputBufferReturnsLeftover)
+{
+    OrderBook book;
+    for (Price p = 50; p > 46; --p) book.addBid(LimitOrder{OrderSide::Bid, 2, nextID(), p, LimitType::GTC});
+    std::array<ExecutionReport, 2> out;
+    std::size_t written{};
+
+    Quantity left = book.sweep(OrderSide::Ask, 7, marketLimit(OrderSide::Ask), out, written);
+    EXPECT_EQ(written, 2u);
+    EXPECT_EQ(left, 3u);
+    EXPECT_EQ(book.bestBid(), 48);
+
+    left = book.sweep(OrderSide::Ask, left, marketLimit(OrderSide::Ask), out, written);
+    EXPECT_EQ(written, 2u);
+    EXPECT_EQ(left, 0u);
+    EXPECT_EQ(out[1].remainingQTY, 1u); // partial fill stays resting
+    EXPECT_EQ(book.bestBid(), 47);
+}
+
+TEST(SweepTest, EngineSweepsMoreOrdersThanOneChunk)
+{
+    MatchingEngine engine;
+    for (int i = 0; i < 100; ++i) engine.submitLimitOrder(kTicker, OrderSide::Ask, 1, nextID(), 100 + i % 5);
+    engine.submitMarketOrder(kTicker, OrderSide::Bid, 90, nextID());
+    EXPECT_EQ(engine.getLogSize(), 90u);
+    EXPECT_EQ(engine.orderIndex.size(), 10u);
+    EXPECT_EQ(engine.bestAsk(kTicker), 104);
+}
+
+TEST(SweepTest, WholeLevelsReturnEverySlotToThePool)
+{
+    OrderBook book(PriceBand{1, 300});
+    book.reserveOrders(64);
+    const std::size_t before = book.m_pool.available();
+    for (Price p = 100; p < 105; ++p)
+        for (int i = 0; i < 4; ++i) book.addAsk(LimitOrder{OrderSide::Ask, 2, nextID(), p, LimitType::GTC});
+    std::array<ExecutionReport, 32> out;
+    std::size_t written{};
+
+    const Quantity left = book.sweep(OrderSide::Bid, 33, marketLimit(OrderSide::Bid), out, written);
+    EXPECT_EQ(left, 0u);
+    EXPECT_EQ(written, 17u); // four whole levels, then one partial fill
+    EXPECT_EQ(out[15].remainingQTY, 0u);
+    EXPECT_EQ(out[16].remainingQTY, 1u);
+    EXPECT_EQ(book.bestAsk(), 104);
+    EXPECT_EQ(book.m_pool.available(), before - 4);
+    EXPECT_EQ(book.m_AskSide.bestLevel().levelQTY, 7u);
+}
+
+TEST(SweepTest, WholeLevelSplitAcrossOutputBuffers)
+{
+    OrderBook book;
+    std::vector<OrderID> ids;
+    for (int i = 0; i < 5; ++i)
+    {
+        ids.push_back(nextID());
+        book.addBid(LimitOrder{OrderSide::Bid, 3, ids.back(), 90, LimitType::GTC});
+    }
+    std::array<ExecutionReport, 3> out;
+    std::size_t written{};
+
+    Quantity left = book.sweep(OrderSide::Ask, 20, 90, out, written);
+    EXPECT_EQ(written, 3u);
+    EXPECT_EQ(left, 11u);
+    EXPECT_EQ(book.m_BidSide.bestLevel().levelQTY, 6u); // two orders still queued
+
+    left = book.sweep(OrderSide::Ask, left, 90, out, written);
+    EXPECT_EQ(written, 2u);
+    EXPECT_EQ(out[0].restingID, ids[3]);
+    EXPECT_EQ(out[1].restingID, ids[4]);
+    EXPECT_EQ(left, 5u);
+    EXPECT_FALSE(book.hasBids());
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Cumulative Depth Tests
+// ─────────────────────────────────────────────────────────────────────────────
+
+TEST(FenwickTreeTest, PrefixSumsTrackAddsAndSubtracts)
+{
+    FenwickTree tree(100);
+    tree.add(0, 5);
+    tree.add(37, 10);
+    tree.add(99, 1);
+    tree.subtract(37, 4);
+    EXPECT_EQ(tree.prefix(0), 5u);
+    EXPECT_EQ(tree.prefix(36), 5u);
+    EXPECT_EQ(tree.prefix(37), 11u);
+    EXPECT_EQ(tree.prefix(99), 12u);
+    EXPECT_EQ(tree.total(), 12u);
+}
+
+TEST(FenwickTreeTest, LadderFOKHandlesLimitsOutsideBand)
+{
+    OrderBook book(PriceBand{100, 200});
+    book.addAsk(LimitOrder{OrderSide::Ask, 5, nextID(), 100, LimitType::GTC});
+    book.addBid(LimitOrder{OrderSide::Bid, 5, nextID(), 200, LimitType::GTC});
+    EXPECT_FALSE(book.FOKVolumeCheck(OrderSide::Bid, 99, 1));
+    EXPECT_TRUE(book.FOKVolumeCheck(OrderSide::Bid, 500, 5));
+    EXPECT_FALSE(book.FOKVolumeCheck(OrderSide::Ask, 201, 1));
+    EXPECT_TRUE(book.FOKVolumeCheck(OrderSide::Ask, 10, 5));
+    EXPECT_FALSE(book.FOKVolumeCheck(OrderSide::Ask, 10, 6));
+}
+
+TEST(FenwickTreeTest, LadderDepthAgreesWithMapUnderRandomFlow)
+{
+    // Adds, fills, cancels and reduces all move the ladder's depth tree; the
+    // std::map book answers the same question by walking its levels.
+    MatchingEngine mapEngine(1);
+    MatchingEngine ladder = ladderEngine();
+    std::mt19937 rng(11);
+    std::vector<OrderID> live;
+    for (int i = 0; i < 20'000; ++i)
+    {
+        const auto side = rng() % 2 ? OrderSide::Bid : OrderSide::Ask;
+        const Price price = static_cast<Price>(100 + rng() % 60);
+        const Quantity qty = static_cast<Quantity>(1 + rng() % 20);
+        const OrderID id = nextID();
+        switch (rng() % 5)
+        {
+        case 0:
+        case 1:
+            mapEngine.submitLimitOrder(kTicker, side, qty, id, price);
+            ladder.submitLimitOrder(kTicker, side, qty, id, price);
+            live.push_back(id);
+            break;
+        case 2:
+            mapEngine.submitLimitOrder(kTicker, side, qty, id, price, LimitType::FOK);
+            ladder.submitLimitOrder(kTicker, side, qty, id, price, LimitType::FOK);
+            break;
+        case 3:
+            if (!live.empty())
+            {
+                const OrderID victim = live[rng() % live.size()];
+                EXPECT_EQ(mapEngine.cancelOrder(victim), ladder.cancelOrder(victim));
+            }
+            break;
+        case 4:
+            if (!live.empty())
+            {
+                const OrderID victim = live[rng() % live.size()];
+                EXPECT_EQ(mapEngine.reduceOrder(victim, 1), ladder.reduceOrder(victim, 1));
+            }
+            break;
+        }
+        const Price probe = static_cast<Price>(90 + rng() % 80);
+        const Quantity volume = static_cast<Quantity>(1 + rng() % 200);
+        ASSERT_EQ(mapEngine.book[kTicker].FOKVolumeCheck(side, probe, volume),
+                  ladder.book[kTicker].FOKVolumeCheck(side, probe, volume));
+    }
+    EXPECT_EQ(mapEngine.getLogSize(), ladder.getLogSize());
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Side Kernel Tests
+// ─────────────────────────────────────────────────────────────────────────────
+
+TEST(SideKernelTest, TemplatedBookCallsMatchRuntimeWrappers)
+{
+    OrderBook book;
+    const OrderHandle bid = book.add<OrderSide::Bid>(LimitOrder{OrderSide::Bid, 10, nextID(), 99, LimitType::GTC});
+    book.addAsk(LimitOrder{OrderSide::Ask, 10, nextID(), 101, LimitType::GTC});
+    EXPECT_EQ(book.bestBid(), 99);
+    EXPECT_TRUE(book.FOKVolumeCheck<OrderSide::Ask>(99, 10));
+    EXPECT_FALSE(book.FOKVolumeCheck<OrderSide::Bid>(100, 1));
+
+    book.reduceQuantity<OrderSide::Bid>(bid, 99, 4);
+    EXPECT_EQ(book.restingQuantity(LookUp{OrderSide::Bid, bid, 99}), 4u);
+    const auto report = book.consumeBest<OrderSide::Ask>(3);
+    ASSERT_TRUE(report.has_value());
+    EXPECT_EQ(report->remainingQTY, 1u);
+    book.cancelOrder<OrderSide::Bid>(bid, 99);
+    EXPECT_FALSE(book.hasBids());
+}
+
+TEST(SideKernelTest, MirroredFlowProducesMirroredBook)
+{
+    // One kernel serves both sides, so swapping every side and reflecting every
+    // price around 500 must give the same fills and a reflected book.
+    auto flip = [](OrderSide side) { return side == OrderSide::Bid ? OrderSide::Ask : OrderSide::Bid; };
+    MatchingEngine engine;
+    MatchingEngine mirror;
+    std::mt19937 rng(23);
+    for (int i = 0; i < 5'000; ++i)
+    {
+        const auto side = rng() % 2 ? OrderSide::Bid : OrderSide::Ask;
+        const Price price = static_cast<Price>(480 + rng() % 40);
+        const Quantity qty = static_cast<Quantity>(1 + rng() % 15);
+        const auto type = static_cast<LimitType>(rng() % 3);
+        const OrderID id = nextID();
+        Command original = rng() % 6 == 0 ? Command::market(kTicker, side, qty, id)
+                                          : Command::limit(kTicker, side, qty, id, price, type);
+        Command reflected = original;
+        reflected.side = flip(side);
+        reflected.price = 1000 - price;
+        const CommandResult a = engine.execute(original);
+        const CommandResult b = mirror.execute(reflected);
+        ASSERT_EQ(a.filledQTY, b.filledQTY);
+        ASSERT_EQ(a.restedQTY, b.restedQTY);
+    }
+    EXPECT_EQ(engine.getLogSize(), mirror.getLogSize());
+    auto reflect = [](std::optional<Price> price) { return price ? std::optional<Price>{1000 - *price} : price; };
+    EXPECT_EQ(engine.bestBid(kTicker), reflect(mirror.bestAsk(kTicker)));
+    EXPECT_EQ(engine.bestAsk(kTicker), reflect(mirror.bestBid(kTicker)));
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Memory Resource and Reset Tests
+// ─────────────────────────────────────────────────────────────────────────────
+
+// Forwards to new/delete and counts what passes through.
+class CountingResource : public std::pmr::memory_resource
+{
+    public:
+    std::size_t allocations{};
+    std::size_t bytesLive{};
+
+    private:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override
+    {
+        ++allocations;
+        bytesLive += bytes;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override
+    {
+        bytesLive -= bytes;
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+};
+
+static void tradeEpisode(MatchingEngine& engine)
+{
+    for (int i = 0; i < 300; ++i)
+    {
+        const auto side = i % 2 ? OrderSide::Bid : OrderSide::Ask;
+        const Price price = static_cast<Price>(side == OrderSide::Bid ? 100 + i % 7 : 103 + i % 7);
+        engine.submitLimitOrder(static_cast<SymbolID>(i % 3), side, 5, nextID(), price);
+    }
+    engine.submitMarketOrder(0, OrderSide::Bid, 40, nextID());
+    engine.submitMarketOrder(1, OrderSide::Ask, 40, nextID());
+}
+
+TEST(ResetTest, EngineAllocatesOnlyFromItsResource)
+{
+    CountingResource resource;
+    {
+        MatchingEngine engine(3, &resource);
+        tradeEpisode(engine);
+        EXPECT_GT(resource.allocations, 0u);
+        EXPECT_GT(resource.bytesLive, 0u);
+        EXPECT_GT(engine.getLogSize(), 0u);
+    }
+    EXPECT_EQ(resource.bytesLive, 0u);
+}
+
+TEST(ResetTest, ResetEmptiesEngineAndRestartsTradeIDs)
+{
+    MatchingEngine engine = MatchingEngine(3, PriceBand{1, 300});
+    tradeEpisode(engine);
+    ASSERT_GT(engine.orderIndex.size(), 0u);
+    const std::size_t indexCapacity = engine.orderIndex.capacity();
+    const std::size_t poolCapacity = engine.book[0].m_pool.capacity();
+
+    engine.reset();
+    for (SymbolID ticker = 0; ticker < 3; ++ticker)
+    {
+        EXPECT_FALSE(engine.hasBid(ticker));
+        EXPECT_FALSE(engine.hasAsk(ticker));
+        EXPECT_FALSE(engine.book[ticker].FOKVolumeCheck(OrderSide::Bid, 300, 1));
+        EXPECT_FALSE(engine.book[ticker].FOKVolumeCheck(OrderSide::Ask, 1, 1));
+    }
+    EXPECT_EQ(engine.orderIndex.size(), 0u);
+    EXPECT_EQ(engine.orderIndex.capacity(), indexCapacity);
+    EXPECT_EQ(engine.book[0].m_pool.capacity(), poolCapacity);
+    EXPECT_EQ(engine.book[0].m_pool.available(), poolCapacity);
+    EXPECT_EQ(engine.getLogSize(), 0u);
+
+    engine.submitLimitOrder(0, OrderSide::Ask, 5, nextID(), 100);
+    engine.submitMarketOrder(0, OrderSide::Bid, 5, nextID());
+    EXPECT_EQ(engine.id, 1u);
+    EXPECT_FALSE(engine.hasAsk(0));
+}
+
+TEST(ResetTest, LadderEpisodeAfterResetDoesNotAllocate)
+{
+    CountingResource resource;
+    MatchingEngine engine(3, PriceBand{1, 300}, &resource);
+    tradeEpisode(engine);
+    engine.reset();
+    const std::size_t warm = resource.allocations;
+
+    tradeEpisode(engine);
+    EXPECT_EQ(resource.allocations, warm);
+    EXPECT_GT(engine.getLogSize(), 0u);
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Fixed Capacity Tests
+// ─────────────────────────────────────────────────────────────────────────────
+
+static EngineLimits smallLimits()
+{
+    EngineLimits limits;
+    limits.maxSymbols = 2;
+    limits.maxOrdersPerBook = 4;
+    limits.maxOrders = 6;
+    limits.band = PriceBand{1, 300};
+    limits.maxTrades = 8;
+    return limits;
+}
+
+TEST(FixedCapacityTest, RejectsRestingOrdersBeyondLimits)
+{
+    MatchingEngine engine(smallLimits());
+    for (int i = 0; i < 4; ++i)
+    {
+        const CommandResult rested = engine.execute(Command::limit(0, OrderSide::Bid, 1, nextID(), 100));
+        EXPECT_EQ(rested.status, CommandStatus::Accepted);
+    }
+    EXPECT_EQ(engine.execute(Command::limit(0, OrderSide::Bid, 1, nextID(), 100)).status, CommandStatus::Rejected);
+    // IOC never rests, so a full book still takes it.
+    EXPECT_EQ(engine.execute(Command::limit(0, OrderSide::Bid, 1, nextID(), 100, LimitType::IOC)).status,
+              CommandStatus::Accepted);
+
+    engine.execute(Command::limit(1, OrderSide::Ask, 1, nextID(), 200));
+    engine.execute(Command::limit(1, OrderSide::Ask, 1, nextID(), 200));
+    EXPECT_EQ(engine.execute(Command::limit(1, OrderSide::Ask, 1, nextID(), 200)).status, CommandStatus::Rejected);
+
+    const EngineHeadroom room = engine.headroom();
+    EXPECT_EQ(room.restingOrders, 0u);
+    EXPECT_EQ(room.tightestBook, 0u);
+    EXPECT_EQ(room.rejected, 2u);
+    EXPECT_FALSE(engine.configureBook(0, PriceBand{1, 10}));
+}
+
+TEST(FixedCapacityTest, CrossingLimitStillTradesAgainstAFullBook)
+{
+    MatchingEngine engine(smallLimits());
+    for (int i = 0; i < 4; ++i) engine.submitLimitOrder(0, OrderSide::Ask, 5, nextID(), 100 + i);
+    ASSERT_EQ(engine.headroom().tightestBook, 0u);
+
+    // Fully filled: needs no slot, so it trades.
+    const CommandResult filled = engine.execute(Command::limit(0, OrderSide::Bid, 5, nextID(), 100));
+    EXPECT_EQ(filled.status, CommandStatus::Accepted);
+    EXPECT_EQ(filled.filledQTY, 5u);
+    EXPECT_EQ(engine.getLogSize(), 1u);
+    EXPECT_EQ(engine.headroom().rejected, 0u);
+
+    // Taking part of a resting order frees nothing and needs nothing.
+    engine.submitLimitOrder(0, OrderSide::Ask, 5, nextID(), 100);
+    const CommandResult partial = engine.execute(Command::limit(0, OrderSide::Bid, 2, nextID(), 101));
+    EXPECT_EQ(partial.status, CommandStatus::Accepted);
+    EXPECT_EQ(partial.filledQTY, 2u);
+    EXPECT_EQ(engine.book[0].restingOrders(), 4u);
+
+    // A GTC that does not cross still has to rest, and is refused.
+    const CommandResult refused = engine.execute(Command::limit(0, OrderSide::Bid, 2, nextID(), 90));
+    EXPECT_EQ(refused.status, CommandStatus::Rejected);
+    EXPECT_EQ(refused.restedQTY, 0u);
+    EXPECT_FALSE(engine.book[0].hasBids());
+    EXPECT_EQ(engine.headroom().rejected, 1u);
+}
+
+TEST(FixedCapacityTest, TradeRingOverwritesInsteadOfRejecting)
+{
+    MatchingEngine engine(smallLimits());
+    for (int round = 0; round < 3; ++round)
+    {
+        for (int i = 0; i < 4; ++i) engine.submitLimitOrder(0, OrderSide::Ask, 1, nextID(), 100);
+        EXPECT_EQ(engine.execute(Command::market(0, OrderSide::Bid, 4, nextID())).filledQTY, 4u);
+    }
+    EXPECT_EQ(engine.getLogSize(), 12u);
+    EXPECT_EQ(engine.sink.tradelog.capacity(), 8u);
+    EXPECT_EQ(engine.sink.tradelog.oldestSequence(), 4u);
+    EXPECT_EQ(engine.headroom().rejected, 0u);
+}
+
+TEST(FixedCapacityTest, UnusableLimitsThrowBeforeSizingTheArena)
+{
+    EXPECT_THROW(MatchingEngine(EngineLimits{}), std::invalid_argument);
+
+    EngineLimits inverted = smallLimits();
+    inverted.band = PriceBand{100, 1};
+    EXPECT_THROW(MatchingEngine{inverted}, std::invalid_argument);
+
+    EngineLimits nonPositive = smallLimits();
+    nonPositive.band = PriceBand{0, 300};
+    EXPECT_THROW(MatchingEngine{nonPositive}, std::invalid_argument);
+
+    for (std::size_t EngineLimits::*count : {&EngineLimits::maxSymbols, &EngineLimits::maxOrdersPerBook,
+                                             &EngineLimits::maxOrders, &EngineLimits::maxTrades})
+    {
+        EngineLimits empty = smallLimits();
+        empty.*count = 0;
+        EXPECT_THROW(MatchingEngine{empty}, std::invalid_argument);
+    }
+    EXPECT_NO_THROW(MatchingEngine{smallLimits()});
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Trade Ring Tests
+// ─────────────────────────────────────────────────────────────────────────────
+
+static Trade tradeWithID(TradeID id)
+{
+    return Trade{kTicker, id, 100, 1, 1, 2, OrderSide::Bid, 0};
+}
+
+TEST(TradeRingTest, CapacityRoundsUpAndSequencesStartAtZero)
+{
+    TradeLog log(5);
+    EXPECT_EQ(log.capacity(), 8u);
+    EXPECT_EQ(log.nextSequence(), 0u);
+    EXPECT_EQ(log.find(0), nullptr);
+    log.record(tradeWithID(70));
+    ASSERT_NE(log.find(0), nullptr);
+    EXPECT_EQ(log.find(0)->m_TradeID, 70u);
+    EXPECT_EQ(log.lag(0), 1u);
+}
+
+TEST(TradeRingTest, ReaderAcrossWrapReportsOverwrittenTrades)
+{
+    TradeLog log(8);
+    for (TradeID id = 0; id < 13; ++id) log.record(tradeWithID(id));
+    EXPECT_EQ(log.getTradeLogSize(), 13u);
+    EXPECT_EQ(log.oldestSequence(), 5u);
+    EXPECT_EQ(log.find(4), nullptr);
+
+    std::array<Trade, 16> out;
+    const TradeRead lagging = log.read(2, out);
+    EXPECT_EQ(lagging.overwritten, 3u);
+    EXPECT_EQ(lagging.count, 8u);
+    EXPECT_EQ(lagging.next, 13u);
+    for (std::size_t i = 0; i < lagging.count; ++i) EXPECT_EQ(out[i].m_TradeID, 5 + i); // wraps at 8
+
+    std::array<Trade, 3> small;
+    const TradeRead partial = log.read(9, small);
+    EXPECT_EQ(partial.overwritten, 0u);
+    EXPECT_EQ(partial.count, 3u);
+    EXPECT_EQ(partial.next, 12u);
+    EXPECT_EQ(small[2].m_TradeID, 11u);
+    EXPECT_EQ(log.read(13, small).count, 0u);
+}
+
+TEST(TradeRingTest, EngineLogCountsEveryTradeButKeepsTheLatest)
+{
+    MatchingEngine engine;
+    const std::size_t total = TradeLog::kDefaultCapacity + 10;
+    for (std::size_t i = 0; i < total; ++i)
+    {
+        engine.submitLimitOrder(kTicker, OrderSide::Ask, 1, nextID(), 100);
+        engine.submitMarketOrder(kTicker, OrderSide::Bid, 1, nextID());
+    }
+    EXPECT_EQ(engine.getLogSize(), total);
+    EXPECT_EQ(engine.sink.tradelog.oldestSequence(), 10u);
+    EXPECT_EQ(engine.sink.tradelog.find(total - 1)->m_TradeID, total - 1);
+
+    engine.reset();
+    EXPECT_EQ(engine.getLogSize(), 0u);
+    EXPECT_EQ(engine.sink.tradelog.find(0), nullptr);
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Trade Clock Tests
+// ─────────────────────────────────────────────────────────────────────────────
+
+TEST(TradeClockTest, OneStampPerCommandFromVirtualClock)
+{
+    MatchingEngine engine;
+    engine.clock.setSource(TimestampSource::Virtual);
+    engine.clock.setVirtualTime(1'000);
+    for (OrderID id = 1; id <= 40; ++id) engine.submitLimitOrder(kTicker, OrderSide::Ask, 1, id, 100 + static_cast<Price>(id));
+
+    engine.submitMarketOrder(kTicker, OrderSide::Bid, 40, 99);
+    ASSERT_EQ(engine.getLogSize(), 40u);
+    for (std::uint64_t seq = 0; seq < 40; ++seq) EXPECT_EQ(engine.tradeTime(seq), 1'000);
+
+    engine.submitLimitOrder(kTicker, OrderSide::Ask, 1, 200, 150);
+    engine.clock.advance(500);
+    engine.submitMarketOrder(kTicker, OrderSide::Bid, 1, 201);
+    EXPECT_EQ(engine.tradeTime(40), 1'500);
+    EXPECT_EQ(engine.tradeTime(41), std::nullopt);
+}
+
+TEST(TradeClockTest, CounterStampsConvertNearSystemTime)
+{
+    TradeClock clock;
+    ASSERT_EQ(clock.source(), TimestampSource::Counter);
+    const Timestamp first = clock.stamp();
+    const Timestamp second = clock.stamp();
+    EXPECT_LE(first, second);
+
+    const auto system = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    const std::int64_t converted = clock.toNanos(second, TimestampSource::Counter);
+    EXPECT_LT(std::llabs(converted - system), 50'000'000);
+    EXPECT_LE(clock.toNanos(first, TimestampSource::Counter), converted);
+}
+
+TEST(TradeClockTest, SwitchingSourcesKeepsEarlierStampsReadable)
+{
+    MatchingEngine engine;
+    const TradeClock journalClock = engine.clock;   // what a journal codec would hold
+    engine.submitLimitOrder(kTicker, OrderSide::Ask, 3, 1, 100);
+    engine.submitMarketOrder(kTicker, OrderSide::Bid, 1, 2);
+    const std::int64_t counterTime = *engine.tradeTime(0);
+
+    engine.clock.setSource(TimestampSource::Virtual);
+    engine.clock.setVirtualTime(7'000);
+    engine.submitMarketOrder(kTicker, OrderSide::Bid, 1, 3);
+    engine.clock.setSource(TimestampSource::Counter);
+    engine.submitMarketOrder(kTicker, OrderSide::Bid, 1, 4);
+
+    EXPECT_EQ(*engine.tradeTime(0), counterTime);
+    EXPECT_EQ(*engine.tradeTime(1), 7'000);
+    EXPECT_GE(*engine.tradeTime(2), counterTime);
+    const Trade& virtualTrade = *engine.sink.tradelog.find(1);
+    EXPECT_EQ(journalClock.toNanos(virtualTrade.m_Time, virtualTrade.m_TimeSource), 7'000);
+    const Trade& counterTrade = *engine.sink.tradelog.find(2);
+    EXPECT_EQ(journalClock.toNanos(counterTrade.m_Time, counterTrade.m_TimeSource), *engine.tradeTime(2));
+}
+
+TEST(TradeClockTest, SeparateCommandsGetSeparateStamps)
+{
+    MatchingEngine engine;
+    engine.clock.setSource(TimestampSource::System);
+    engine.submitLimitOrder(kTicker, OrderSide::Ask, 2, 1, 100);
+    engine.submitMarketOrder(kTicker, OrderSide::Bid, 1, 2);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    engine.submitMarketOrder(kTicker, OrderSide::Bid, 1, 3);
+
+    ASSERT_EQ(engine.getLogSize(), 2u);
+    EXPECT_GT(*engine.tradeTime(1), *engine.tradeTime(0));
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Event Sink Tests
+// ─────────────────────────────────────────────────────────────────────────────
+
+struct RecordingSink
+{
+    std::vector<Trade> trades;
+    std::vector<OrderEvent> rests;
+    std::vector<OrderEvent> cancels;
+    std::vector<OrderEvent> reduces;
+    std::vector<RejectReason> rejects;
+
+    void onTrade(const Trade& trade) { trades.push_back(trade); }
+    void onRest(const OrderEvent& order) { rests.push_back(order); }
+    void onCancel(const OrderEvent& order) { cancels.push_back(order); }
+    void onReduce(const OrderEvent& order) { reduces.push_back(order); }
+    void onReject(SymbolID, OrderID, RejectReason reason) { rejects.push_back(reason); }
+};
+
+template struct BasicMatchingEngine<RecordingSink>;
+
+TEST(EventSinkTest, BookChangesReachTheSink)
+{
+    BasicMatchingEngine<RecordingSink> engine(2);
+    engine.submitLimitOrder(1, OrderSide::Ask, 10, 1, 100);
+    engine.submitLimitOrder(1, OrderSide::Bid, 4, 2, 101);
+    engine.reduceOrder(1, 2);
+    engine.cancelReplace(1, 5, 102);
+
+    ASSERT_EQ(engine.sink.rests.size(), 2u);
+    EXPECT_EQ(engine.sink.rests[0].symbol, 1u);
+    EXPECT_EQ(engine.sink.rests[0].side, OrderSide::Ask);
+    EXPECT_EQ(engine.sink.rests[0].qty, 10);
+    EXPECT_EQ(engine.sink.rests[1].price, 102);
+    EXPECT_EQ(engine.sink.rests[1].qty, 5);
+
+    ASSERT_EQ(engine.sink.trades.size(), 1u);
+    EXPECT_EQ(engine.sink.trades[0].m_Qty, 4);
+    EXPECT_EQ(engine.sink.trades[0].m_RestingOrderID, 1u);
+
+    ASSERT_EQ(engine.sink.reduces.size(), 1u);
+    EXPECT_EQ(engine.sink.reduces[0].qty, 4); // 6 resting cut to 2
+
+    ASSERT_EQ(engine.sink.cancels.size(), 1u);
+    EXPECT_EQ(engine.sink.cancels[0].id, 1u);
+    EXPECT_EQ(engine.sink.cancels[0].price, 100);
+    EXPECT_EQ(engine.sink.cancels[0].qty, 2);
+    EXPECT_TRUE(engine.sink.rejects.empty());
+}
+
+TEST(EventSinkTest, RejectsCarryTheirReason)
+{
+    BasicMatchingEngine<RecordingSink> engine(1, PriceBand{1, 200});
+    engine.submitLimitOrder(kTicker, OrderSide::Bid, 0, 1, 100);
+    engine.submitLimitOrder(kTicker, OrderSide::Bid, 5, 2, 500);
+    engine.submitMarketOrder(kTicker, OrderSide::Ask, 0, 3);
+    engine.cancelOrder(99);
+    engine.submitLimitOrder(kTicker, OrderSide::Bid, 5, 4, 100);
+    engine.reduceOrder(4, 7);
+    engine.execute(Command::reduce(98, 1));
+    engine.submitLimitOrder(kTicker, OrderSide::Bid, 5, OrderIndex::kEmpty, 100);
+
+    const std::vector<RejectReason> expected{RejectReason::InvalidQuantity, RejectReason::InvalidPrice,
+                                             RejectReason::InvalidQuantity, RejectReason::UnknownOrder,
+                                             RejectReason::InvalidQuantity, RejectReason::UnknownOrder,
+                                             RejectReason::InvalidOrderID};
+    EXPECT_EQ(engine.sink.rejects, expected);
+    EXPECT_EQ(engine.book[kTicker].restingOrders(), 1u);
+
+    BasicMatchingEngine<RecordingSink> bounded(smallLimits());
+    for (OrderID id = 1; id <= 5; ++id) bounded.submitLimitOrder(0, OrderSide::Bid, 1, id, 100);
+    ASSERT_EQ(bounded.sink.rejects.size(), 1u);
+    EXPECT_EQ(bounded.sink.rejects[0], RejectReason::CapacityLimit);
+}
+
+TEST(EventSinkTest, LiveOrderIDCannotBeReusedOnAnotherSymbol)
+{
+    BasicMatchingEngine<RecordingSink> engine(2);
+    engine.submitLimitOrder(1, OrderSide::Bid, 5, 42, 100);
+    engine.submitLimitOrder(0, OrderSide::Ask, 5, 900, 100);
+    engine.submitLimitOrder(0, OrderSide::Bid, 5, 42, 100);   // would trade, then leave 42 unindexed
+    EXPECT_EQ(engine.execute(Command::limit(0, OrderSide::Bid, 1, 42, 90)).status, CommandStatus::Rejected);
+    const std::vector<RejectReason> expected{RejectReason::DuplicateOrderID, RejectReason::DuplicateOrderID};
+    EXPECT_EQ(engine.sink.rejects, expected);
+    EXPECT_TRUE(engine.sink.trades.empty());
+    EXPECT_TRUE(engine.hasAsk(0));
+
+    EXPECT_TRUE(engine.cancelOrder(42));
+    EXPECT_FALSE(engine.hasBid(1));
+    EXPECT_EQ(engine.orderIndex.size(), 1u);
+
+    // Once the order is gone its ID is free again.
+    engine.submitLimitOrder(0, OrderSide::Bid, 5, 42, 100);
+    EXPECT_EQ(engine.sink.trades.size(), 1u);
+    EXPECT_EQ(engine.sink.rejects.size(), 2u);
+}
+
+TEST(EventSinkTest, TickerPastTheLastBookIsRejected)
+{
+    const EngineLimits limits = smallLimits();
+    BasicMatchingEngine<RecordingSink> engine(limits);
+    const SymbolID unknown = static_cast<SymbolID>(limits.maxSymbols);
+    engine.submitLimitOrder(unknown, OrderSide::Bid, 5, 1, 100);
+    engine.submitMarketOrder(unknown, OrderSide::Ask, 5, 2);
+
+    // The bad tickers sit past the prefetch distance, so the batch warms
+    // them ahead of running them.
+    const Command commands[] = {
+        Command::limit(0, OrderSide::Ask, 5, 3, 100),
+        Command::limit(0, OrderSide::Ask, 5, 4, 101),
+        Command::limit(1, OrderSide::Ask, 5, 5, 100),
+        Command::limit(1, OrderSide::Ask, 5, 6, 101),
+        Command::limit(unknown, OrderSide::Bid, 5, 7, 100),
+        Command::market(unknown, OrderSide::Bid, 5, 8),
+    };
+    CommandResult results[6];
+    engine.processBatch(commands, results, {});
+    EXPECT_EQ(results[4].status, CommandStatus::Rejected);
+    EXPECT_EQ(results[5].status, CommandStatus::Rejected);
+
+    const std::vector<RejectReason> expected(4, RejectReason::UnknownSymbol);
+    EXPECT_EQ(engine.sink.rejects, expected);
+    EXPECT_TRUE(engine.sink.trades.empty());
+    EXPECT_EQ(engine.orderIndex.size(), 4u);
+}
+
+TEST(EventSinkTest, NullSinkEngineMatchesLikeTheDefault)
+{
+    BasicMatchingEngine<NullSink> quiet(1);
+    MatchingEngine logged(1);
+    std::mt19937 rng(17);
+    for (OrderID id = 1; id <= 2'000; ++id)
+    {
+        const auto side = rng() % 2 ? OrderSide::Bid : OrderSide::Ask;
+        const auto qty = static_cast<Quantity>(rng() % 20 + 1);
+        const auto price = static_cast<Price>(rng() % 40 + 80);
+        quiet.submitLimitOrder(kTicker, side, qty, id, price);
+        logged.submitLimitOrder(kTicker, side, qty, id, price);
+        if (id % 7 == 0)
+        {
+            quiet.cancelOrder(id - 3);
+            logged.cancelOrder(id - 3);
+        }
+    }
+    EXPECT_EQ(quiet.bestBid(kTicker), logged.bestBid(kTicker));
+    EXPECT_EQ(quiet.bestAsk(kTicker), logged.bestAsk(kTicker));
+    EXPECT_EQ(quiet.orderIndex.size(), logged.orderIndex.size());
+    EXPECT_EQ(quiet.id, logged.getLogSize());
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Trade Journal Tests
+// ─────────────────────────────────────────────────────────────────────────────
+
+static std::string journalPath(const char* name)
+{
+    const std::string path = testing::TempDir() + name;
+    std::remove(path.c_str());
+    return path;
+}
+
+static std::vector<JournalRecord> readAll(const std::string& path)
+{
+    JournalReader reader(path);
+    std::vector<JournalRecord> records;
+    std::array<JournalRecord, 7> chunk;
+    while (const std::size_t count = reader.read(chunk)) records.insert(records.end(), chunk.begin(), chunk.begin() + static_cast<std::ptrdiff_t>(count));
+    return records;
+}
+
+TEST(TradeJournalTest, EngineTradesLandInTheFileInOrder)
+{
+    const std::string path = journalPath("engine.trj");
+    MatchingEngine engine(2);
+    {
+        TradeJournal journal(path, engine.clock);
+        engine.sink.journal = &journal;
+        for (OrderID id = 1; id <= 50; ++id) engine.submitLimitOrder(1, OrderSide::Ask, 2, id, 100 + id % 5);
+        engine.submitMarketOrder(1, OrderSide::Bid, 100, 1000);
+        journal.flush();
+        EXPECT_EQ(journal.backlog(), 0u);
+        EXPECT_EQ(journal.written(), 50u);
+        engine.sink.journal = nullptr;
+    }
+
+    ASSERT_TRUE(JournalReader(path).valid());
+    const std::vector<JournalRecord> records = readAll(path);
+    ASSERT_EQ(records.size(), engine.getLogSize());
+    for (std::size_t i = 0; i < records.size(); ++i)
+    {
+        const Trade& trade = *engine.sink.tradelog.find(i);
+        EXPECT_EQ(records[i].tradeID, trade.m_TradeID);
+        EXPECT_EQ(records[i].symbol, 1u);
+        EXPECT_EQ(records[i].price, trade.m_Price);
+        EXPECT_EQ(records[i].qty, trade.m_Qty);
+        EXPECT_EQ(records[i].aggressorID, 1000);
+        EXPECT_EQ(records[i].restingID, trade.m_RestingOrderID);
+        EXPECT_EQ(records[i].aggressorSide, 0u);
+        EXPECT_EQ(records[i].timeNs, engine.tradeTime(i));
+    }
+}
+
+TEST(TradeJournalTest, ReopenAppendsAfterTheLastWholeRecord)
+{
+    const std::string path = journalPath("reopen.trj");
+    const TradeClock clock;
+    {
+        TradeJournal journal(path, clock);
+        for (TradeID id = 0; id < 3; ++id) journal.append(Trade{0, id, 100, 1, 1, 2, OrderSide::Bid, clock.stamp()});
+    }
+    {
+        std::ofstream torn(path, std::ios::binary | std::ios::app);
+        torn.write("partial", 7);
+    }
+    {
+        TradeJournal journal(path, clock);
+        for (TradeID id = 3; id < 5; ++id) journal.append(Trade{0, id, 100, 1, 1, 2, OrderSide::Ask, clock.stamp()});
+    }
+    const std::vector<JournalRecord> records = readAll(path);
+    ASSERT_EQ(records.size(), 5u);
+    for (std::size_t i = 0; i < records.size(); ++i) EXPECT_EQ(records[i].tradeID, i);
+    EXPECT_EQ(records[4].aggressorSide, 1u);
+
+    const std::string other = journalPath("other.trj");
+    {
+        std::ofstream junk(other, std::ios::binary);
+        junk << "not a journal at all";
+    }
+    EXPECT_THROW(TradeJournal(other, clock), std::system_error);
+    EXPECT_FALSE(JournalReader(other).valid());
+}
+
+TEST(TradeJournalTest, FullRingStallsInsteadOfDropping)
+{
+    const std::string path = journalPath("stall.trj");
+    const TradeClock clock;
+    JournalOptions options;
+    options.ringCapacity = 4;
+    options.batchRecords = 16;
+    options.sync = JournalSync::EveryWrite;
+    constexpr TradeID kTrades = 2'000;
+    {
+        TradeJournal journal(path, clock, options);
+        for (TradeID id = 0; id < kTrades; ++id) journal.append(Trade{0, id, 100, 1, 1, 2, OrderSide::Bid, clock.stamp()});
+        journal.flush();
+        EXPECT_EQ(journal.written(), kTrades);
+        EXPECT_GT(journal.syncs(), 0u);
+        EXPECT_FALSE(journal.failed());
+    }
+    EXPECT_EQ(readAll(path).size(), kTrades);
+}
+
+TEST(TradeJournalTest, PeriodicSyncCatchesTheTailOfAnIdleJournal)
+{
+    const std::string path = journalPath("periodic.trj");
+    const TradeClock clock;
+    JournalOptions options;
+    options.sync = JournalSync::Periodic;
+    options.syncInterval = std::chrono::milliseconds(200);
+    TradeJournal journal(path, clock, options);
+    journal.append(Trade{0, 0, 100, 1, 1, 2, OrderSide::Bid, clock.stamp()});
+    journal.flush();
+    EXPECT_EQ(journal.syncs(), 1u);   // the first write is past any interval
+
+    // Written inside the interval, then nothing more arrives: the writer
+    // syncs it on its own once the interval is up.
+    journal.append(Trade{0, 1, 100, 1, 1, 2, OrderSide::Bid, clock.stamp()});
+    journal.flush();
+    EXPECT_EQ(journal.syncs(), 1u);
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (journal.syncs() < 2 && std::chrono::steady_clock::now() < deadline) std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    EXPECT_EQ(journal.syncs(), 2u);
+    std::this_thread::sleep_for(std::chrono::milliseconds(250));
+    EXPECT_EQ(journal.syncs(), 2u);   // nothing new, nothing to sync
+}
+
+TEST(TradeJournalTest, IdleWriterSleepsInsteadOfHoldingACore)
+{
+    const std::string path = journalPath("idle.trj");
+    const TradeClock clock;
+    TradeJournal journal(path, clock);
+    journal.append(Trade{0, 0, 100, 1, 1, 2, OrderSide::Bid, clock.stamp()});
+    journal.flush();
+
+    // The only thread that could burn CPU while this one sleeps is the writer.
+    const std::clock_t before = std::clock();
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    const double cpuSeconds = static_cast<double>(std::clock() - before) / CLOCKS_PER_SEC;
+    EXPECT_LT(cpuSeconds, 0.1);
+
+    journal.append(Trade{0, 1, 100, 1, 1, 2, OrderSide::Bid, clock.stamp()});
+    journal.flush();
+    EXPECT_EQ(journal.written(), 2u);
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Command Log Tests
+// ─────────────────────────────────────────────────────────────────────────────
+
+TEST(CommandLogTest, ReplayRebuildsBooksWithoutRepublishing)
+{
+    const std::string path = journalPath("commands.cml");
+    MatchingEngine live(4);
+    std::vector<OrderID> ids;
+    {
+        CommandLog log(path, CommandCodec{});
+        live.commandLog = &log;
+        std::mt19937 rng(20);
+        for (int i = 0; i < 5'000; ++i)
+        {
+            const auto ticker = static_cast<SymbolID>(rng() % 4);
+            const auto side = rng() % 2 ? OrderSide::Bid : OrderSide::Ask;
+            const auto price = static_cast<Price>(rng() % 30 + 90);
+            const auto qty = static_cast<Quantity>(rng() % 10 + 1);
+            switch (rng() % 6)
+            {
+            case 0: live.submitMarketOrder(ticker, side, qty, nextID()); break;
+            case 1: if (!ids.empty()) live.cancelOrder(ids[rng() % ids.size()]); break;
+            case 2: if (!ids.empty()) live.reduceOrder(ids[rng() % ids.size()], qty); break;
+            case 3: if (!ids.empty()) live.cancelReplace(ids[rng() % ids.size()], qty, price); break;
+            case 4: live.execute(Command::limit(ticker, side, qty, ids.emplace_back(nextID()), price, LimitType::IOC)); break;
+            default: live.submitLimitOrder(ticker, side, qty, ids.emplace_back(nextID()), price); break;
+            }
+        }
+        live.commandLog = nullptr;
+    }
+
+    MatchingEngine recovered(4);
+    CommandLogReader reader(path);
+    ASSERT_TRUE(reader.valid());
+    const ReplaySummary summary = recovered.replay(reader);
+    EXPECT_FALSE(summary.gap);
+    EXPECT_EQ(summary.commands, summary.nextSequence);
+    EXPECT_GT(summary.commands, 0u);
+
+    EXPECT_EQ(recovered.getLogSize(), 0u);
+    EXPECT_EQ(recovered.id, live.id);
+    EXPECT_EQ(recovered.orderIndex.size(), live.orderIndex.size());
+    for (SymbolID ticker = 0; ticker < 4; ++ticker)
+    {
+        EXPECT_EQ(recovered.bestBid(ticker), live.bestBid(ticker));
+        EXPECT_EQ(recovered.bestAsk(ticker), live.bestAsk(ticker));
+        EXPECT_EQ(recovered.book[ticker].restingOrders(), live.book[ticker].restingOrders());
+    }
+    for (OrderID id : ids)
+    {
+        const IndexEntry* expected = live.orderIndex.find(id);
+        const IndexEntry* found = recovered.orderIndex.find(id);
+        ASSERT_EQ(found == nullptr, expected == nullptr);
+        if (found != nullptr)
+        {
+            EXPECT_EQ(recovered.book[found->symbol].restingQuantity(found->location),
+                      live.book[expected->symbol].restingQuantity(expected->location));
+        }
+    }
+}
+
+TEST(CommandLogTest, OnlyAcceptedCommandsAreLoggedAndReplacementsKeepTheirID)
+{
+    const std::string path = journalPath("accepted.cml");
+    MatchingEngine engine(1, PriceBand{1, 200});
+    {
+        CommandLog log(path, CommandCodec{});
+        engine.commandLog = &log;
+        engine.submitLimitOrder(kTicker, OrderSide::Bid, 5, 1, 100);
+        engine.submitLimitOrder(kTicker, OrderSide::Bid, 0, 2, 100);   // rejected
+        engine.submitLimitOrder(kTicker, OrderSide::Bid, 5, 3, 900);   // rejected
+        engine.cancelOrder(42);                                        // unknown
+        engine.reduceOrder(1, 9);                                      // would grow
+        engine.cancelReplace(1, 4, 101);
+        log.flush();
+        EXPECT_EQ(log.written(), 2u);
+        engine.commandLog = nullptr;
+    }
+
+    CommandLogReader reader(path);
+    std::array<CommandRecord, 8> records;
+    ASSERT_EQ(reader.read(records), 2u);
+    EXPECT_EQ(records[0].sequence, 0u);
+    EXPECT_EQ(records[1].sequence, 1u);
+    EXPECT_EQ(records[1].type, static_cast<std::uint8_t>(Command::Type::CancelReplace));
+    const OrderID replacement = records[1].newID;
+    ASSERT_NE(replacement, 0);
+    EXPECT_NE(engine.orderIndex.find(replacement), nullptr);
+
+    CommandLog reopened(path, CommandCodec{});
+    EXPECT_EQ(reopened.existing(), 2u);
+
+    MatchingEngine recovered(1, PriceBand{1, 200});
+    CommandLogReader again(path);
+    recovered.replay(again);
+    EXPECT_NE(recovered.orderIndex.find(replacement), nullptr);
+    EXPECT_EQ(recovered.bestBid(kTicker), 101);
+    EXPECT_GT(OrderIDGenerator::next(), replacement);
+}
+
+TEST(CommandLogTest, ReplayStopsAtASequenceGap)
+{
+    const std::string path = journalPath("gap.cml");
+    {
+        JournalFile file(path, CommandCodec::kHeader);
+        const CommandCodec codec;
+        const std::array<CommandRecord, 3> records{
+            codec.encode(Command::limit(kTicker, OrderSide::Ask, 5, 1, 100), 0),
+            codec.encode(Command::limit(kTicker, OrderSide::Ask, 5, 2, 101), 1),
+            codec.encode(Command::limit(kTicker, OrderSide::Ask, 5, 3, 102), 3),
+        };
+        ASSERT_TRUE(file.append(records.data(), sizeof(records)));
+    }
+    MatchingEngine engine;
+    CommandLogReader reader(path);
+    const ReplaySummary summary = engine.replay(reader);
+    EXPECT_TRUE(summary.gap);
+    EXPECT_EQ(summary.commands, 2u);
+    EXPECT_EQ(summary.nextSequence, 2u);
+    EXPECT_EQ(engine.orderIndex.size(), 2u);
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Snapshot Tests
+// ─────────────────────────────────────────────────────────────────────────────
+
+// Random flow over two books, one ladder and one std::map, so the snapshot has
+// queues, free-list slots and index entries of both kinds.
+static void churn(MatchingEngine& engine, std::vector<OrderID>& ids, std::mt19937& rng, int count)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        const auto ticker = static_cast<SymbolID>(rng() % 2);
+        const auto side = rng() % 2 ? OrderSide::Bid : OrderSide::Ask;
+        const auto price = static_cast<Price>(rng() % 30 + 90);
+        const auto qty = static_cast<Quantity>(rng() % 10 + 1);
+        switch (rng() % 6)
+        {
+        case 0: engine.submitMarketOrder(ticker, side, qty, nextID()); break;
+        case 1: if (!ids.empty()) engine.cancelOrder(ids[rng() % ids.size()]); break;
+        case 2: if (!ids.empty()) engine.reduceOrder(ids[rng() % ids.size()], qty); break;
+        case 3: if (!ids.empty()) engine.cancelReplace(ids[rng() % ids.size()], qty, price); break;
+        default: engine.submitLimitOrder(ticker, side, qty, ids.emplace_back(nextID()), price); break;
+        }
+    }
+}
+
+static MatchingEngine snapshotEngine()
+{
+    MatchingEngine engine(2);
+    engine.configureBook(0, PriceBand{1, 200});
+    return engine;
+}
+
+// Sweeps both sides of every book and returns (resting ID, quantity) per fill,
+// which pins down every queue's contents and order.
+static std::vector<std::pair<OrderID, Quantity>> sweepAll(MatchingEngine& engine)
+{
+    const std::uint64_t first = engine.sink.tradelog.nextSequence();
+    for (SymbolID ticker = 0; ticker < engine.book.size(); ++ticker)
+    {
+        engine.submitMarketOrder(ticker, OrderSide::Bid, 1'000'000, 0);
+        engine.submitMarketOrder(ticker, OrderSide::Ask, 1'000'000, 0);
+    }
+    std::vector<std::pair<OrderID, Quantity>> fills;
+    for (std::uint64_t seq = first; seq < engine.sink.tradelog.nextSequence(); ++seq)
+    {
+        const Trade* trade = engine.sink.tradelog.find(seq);
+        fills.emplace_back(trade->m_RestingOrderID, trade->m_Qty);
+    }
+    return fills;
+}
+
+TEST(SnapshotTest, RoundTripRestoresQueuesIndexAndIDs)
+{
+    const std::string path = journalPath("roundtrip.snap");
+    MatchingEngine live = snapshotEngine();
+    std::vector<OrderID> ids;
+    std::mt19937 rng(21);
+    churn(live, ids, rng, 4'000);
+    ASSERT_TRUE(live.saveSnapshot(path));
+    const OrderID nextOrder = OrderIDGenerator::peek();
+
+    MatchingEngine restored = snapshotEngine();
+    restored.submitLimitOrder(1, OrderSide::Bid, 5, nextID(), 50);   // wiped by the load
+    OrderIDGenerator::reset(1);
+    ASSERT_EQ(restored.loadSnapshot(path), std::optional<std::uint64_t>{0});
+    EXPECT_EQ(OrderIDGenerator::peek(), nextOrder);
+    EXPECT_EQ(restored.id, live.id);
+    EXPECT_EQ(restored.orderIndex.size(), live.orderIndex.size());
+    for (SymbolID ticker = 0; ticker < 2; ++ticker)
+    {
+        EXPECT_EQ(restored.bestBid(ticker), live.bestBid(ticker));
+        EXPECT_EQ(restored.bestAsk(ticker), live.bestAsk(ticker));
+        EXPECT_EQ(restored.book[ticker].restingOrders(), live.book[ticker].restingOrders());
+        EXPECT_EQ(restored.book[ticker].m_BidSide.levelCount(), live.book[ticker].m_BidSide.levelCount());
+    }
+    for (OrderID id : ids)
+    {
+        const IndexEntry* expected = live.orderIndex.find(id);
+        const IndexEntry* found = restored.orderIndex.find(id);
+        ASSERT_EQ(found == nullptr, expected == nullptr);
+        if (found != nullptr)
+        {
+            EXPECT_EQ(restored.book[found->symbol].restingQuantity(found->location),
+                      live.book[expected->symbol].restingQuantity(expected->location));
+        }
+    }
+
+    // Both keep matching identically, recycling the same free slots.
+    std::mt19937 after(22);
+    std::mt19937 afterCopy(22);
+    std::vector<OrderID> liveIDs = ids;
+    const OrderID resume = OrderIDGenerator::peek();
+    churn(live, liveIDs, after, 1'000);
+    OrderIDGenerator::reset(resume);
+    churn(restored, ids, afterCopy, 1'000);
+    const auto fills = sweepAll(live);
+    EXPECT_FALSE(fills.empty());
+    EXPECT_EQ(sweepAll(restored), fills);
+}
+
+TEST(SnapshotTest, SnapshotPlusLogTailMatchesTheLiveEngine)
+{
+    const std::string logPath = journalPath("tail.cml");
+    const std::string snapPath = journalPath("tail.snap");
+    MatchingEngine live = snapshotEngine();
+    std::vector<OrderID> ids;
+    std::mt19937 rng(23);
+    std::uint64_t snapshotSequence{};
+    {
+        CommandLog log(logPath, CommandCodec{});
+        live.commandLog = &log;
+        churn(live, ids, rng, 3'000);
+        snapshotSequence = log.nextSequence();
+        ASSERT_TRUE(live.saveSnapshot(snapPath));
+        churn(live, ids, rng, 3'000);
+        live.commandLog = nullptr;
+    }
+
+    MatchingEngine recovered = snapshotEngine();
+    const std::optional<std::uint64_t> from = recovered.loadSnapshot(snapPath);
+    ASSERT_EQ(from, std::optional<std::uint64_t>{snapshotSequence});
+    CommandLogReader reader(logPath);
+    const ReplaySummary summary = recovered.replay(reader, *from);
+    EXPECT_FALSE(summary.gap);
+    EXPECT_GT(summary.commands, 0u);
+    EXPECT_EQ(summary.nextSequence, snapshotSequence + summary.commands);
+
+    EXPECT_EQ(recovered.id, live.id);
+    EXPECT_EQ(recovered.orderIndex.size(), live.orderIndex.size());
+    EXPECT_EQ(sweepAll(recovered), sweepAll(live));
+}
+
+TEST(SnapshotTest, ForkedSnapshotMatchesAndUnusableFilesAreRejected)
+{
+    const std::string syncPath = journalPath("sync.snap");
+    const std::string forkPath = journalPath("fork.snap");
+    MatchingEngine live = snapshotEngine();
+    std::vector<OrderID> ids;
+    std::mt19937 rng(24);
+    churn(live, ids, rng, 2'000);
+    ASSERT_TRUE(live.saveSnapshot(syncPath));
+    SnapshotJob job = live.snapshotAsync(forkPath);
+    ASSERT_TRUE(job.started());
+    live.submitLimitOrder(1, OrderSide::Bid, 5, nextID(), 60);   // parent keeps going
+    ASSERT_TRUE(job.wait());
+
+    auto contents = [](const std::string& path)
+    {
+        std::ifstream in(path, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(in), {});
+    };
+    const std::string bytes = contents(syncPath);
+    EXPECT_EQ(contents(forkPath), bytes);
+
+    MatchingEngine otherBand(2);
+    otherBand.configureBook(0, PriceBand{1, 300});
+    EXPECT_EQ(otherBand.loadSnapshot(syncPath), std::nullopt);
+    MatchingEngine fewerBooks(1, PriceBand{1, 200});
+    EXPECT_EQ(fewerBooks.loadSnapshot(syncPath), std::nullopt);
+
+    const std::string truncatedPath = journalPath("truncated.snap");
+    std::ofstream(truncatedPath, std::ios::binary).write(bytes.data(), static_cast<std::streamsize>(bytes.size() / 2));
+    MatchingEngine engine = snapshotEngine();
+    engine.submitLimitOrder(0, OrderSide::Ask, 5, nextID(), 100);
+    EXPECT_EQ(engine.loadSnapshot(truncatedPath), std::nullopt);
+    EXPECT_FALSE(engine.hasAsk(0));
+    EXPECT_EQ(engine.orderIndex.size(), 0u);
+    EXPECT_FALSE(MappedSnapshot(journalPath("missing.snap")).valid());
+}
+
+TEST(SnapshotTest, CorruptIndexEntriesAndOrderLinksAreRejected)
+{
+    const std::string path = journalPath("corrupt.snap");
+    MatchingEngine live = snapshotEngine();
+    std::vector<OrderID> ids;
+    std::mt19937 rng(21);
+    churn(live, ids, rng, 1'000);
+    ASSERT_TRUE(live.saveSnapshot(path));
+    std::string bytes;
+    std::uint64_t slotOffset{};
+    std::uint64_t nodeOffset{};
+    std::uint64_t levelOffset{};
+    std::uint64_t headOffset{};
+    IndexEntry used{};
+    OrderHandle freeSlot{};
+    SnapshotLevel firstLevel{};
+    std::uint64_t indexSlots{};
+    {
+        const MappedSnapshot snapshot(path);
+        ASSERT_TRUE(snapshot.valid());
+        const auto slots = snapshot.indexSlots();
+        const auto found = std::ranges::find_if(slots, [](const IndexEntry& slot) { return slot.id != OrderIndex::kEmpty; });
+        ASSERT_NE(found, slots.end());
+        used = *found;
+        slotOffset = snapshot.header().indexOffset + static_cast<std::uint64_t>(found - slots.begin()) * sizeof(IndexEntry);
+        indexSlots = slots.size();
+        const SnapshotBook& book = snapshot.books()[0];
+        ASSERT_GE(book.bidLevels, 2u);
+        ASSERT_NE(book.freeHead, kNullHandle);
+        freeSlot = book.freeHead;
+        firstLevel = snapshot.levels(book)[0];
+        nodeOffset = book.nodesOffset;
+        levelOffset = book.levelsOffset;
+        headOffset = nodeOffset + firstLevel.head * sizeof(OrderNode);
+        std::ifstream in(path, std::ios::binary);
+        bytes.assign(std::istreambuf_iterator<char>(in), {});
+    }
+
+    // Each corruption is patched into a fresh copy of the good file.
+    auto rejects = [&](std::uint64_t offset, auto value)
+    {
+        std::string corrupt = bytes;
+        std::memcpy(corrupt.data() + offset, &value, sizeof(value));
+        std::ofstream(path, std::ios::binary | std::ios::trunc).write(corrupt.data(), static_cast<std::streamsize>(corrupt.size()));
+        MatchingEngine engine = snapshotEngine();
+        const bool rejected = !engine.loadSnapshot(path).has_value();
+        return rejected && engine.orderIndex.size() == 0 && !engine.hasBid(0) && !engine.hasAsk(0);
+    };
+    EXPECT_TRUE(rejects(slotOffset + offsetof(IndexEntry, symbol), std::uint32_t{7}));
+    EXPECT_TRUE(rejects(slotOffset + offsetof(IndexEntry, location), OrderHandle{kNullHandle - 1}));
+    EXPECT_TRUE(rejects(nodeOffset + offsetof(OrderNode, next), OrderHandle{kNullHandle - 1}));
+    EXPECT_TRUE(rejects(nodeOffset + offsetof(OrderNode, prev), OrderHandle{kNullHandle - 1}));
+
+    // An index entry whose side or price names no level holding its order, or
+    // whose handle is a free slot.
+    const std::uint64_t locationOffset = slotOffset + offsetof(IndexEntry, location);
+    const LookUp at = used.location;
+    EXPECT_TRUE(rejects(locationOffset, LookUp{opposite(at.side()), at.handle, at.price()}));
+    EXPECT_TRUE(rejects(locationOffset, LookUp{at.side(), at.handle, at.price() + 1}));
+    EXPECT_TRUE(rejects(locationOffset, LookUp{at.side(), freeSlot, at.price()}));
+
+    // Two bid levels at one price.
+    EXPECT_TRUE(rejects(levelOffset + sizeof(SnapshotLevel) + offsetof(SnapshotLevel, price), firstLevel.price));
+
+    // A queue that loops back on itself, or whose tail is not where its chain ends.
+    EXPECT_TRUE(rejects(headOffset + offsetof(OrderNode, next), firstLevel.head));
+    EXPECT_TRUE(rejects(levelOffset + offsetof(SnapshotLevel, tail), freeSlot));
+
+    // An index size that disagrees with its occupied slots, or fills the table.
+    EXPECT_TRUE(rejects(offsetof(SnapshotHeader, indexSize), std::uint64_t{0}));
+    EXPECT_TRUE(rejects(offsetof(SnapshotHeader, indexSize), indexSlots));
+    EXPECT_FALSE(rejects(0, bytes[0]));   // the untouched file still loads
+}
+
+TEST(SnapshotTest, OverLimitLoadRefusesResidualButKeepsThePartialFill)
+{
+    // A snapshot from an unbounded engine leaves book 0 over its limit, so
+    // the one slot a fill frees is not enough for the residual.
+    const std::string path = journalPath("overfull.snap");
+    MatchingEngine unbounded(2, PriceBand{1, 300});
+    unbounded.submitLimitOrder(0, OrderSide::Ask, 1, nextID(), 100);
+    for (int i = 0; i < 5; ++i) unbounded.submitLimitOrder(0, OrderSide::Ask, 1, nextID(), 200);
+    ASSERT_TRUE(unbounded.saveSnapshot(path));
+
+    MatchingEngine engine(smallLimits());
+    ASSERT_TRUE(engine.loadSnapshot(path).has_value());
+    const CommandResult result = engine.execute(Command::limit(0, OrderSide::Bid, 3, nextID(), 150));
+    EXPECT_EQ(result.status, CommandStatus::ResidualRefused);
+    EXPECT_EQ(result.filledQTY, 1u);
+    EXPECT_EQ(result.restedQTY, 0u);
+    EXPECT_FALSE(engine.book[0].hasBids());
+    EXPECT_EQ(engine.headroom().rejected, 1u);
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Depth Feed Tests
+// ─────────────────────────────────────────────────────────────────────────────
+
+struct DepthSink
+{
+    std::vector<DepthUpdate> updates;
+    std::vector<SymbolID> symbols;
+
+    void onTrade(const Trade&) {}
+    void onRest(const OrderEvent&) {}
+    void onCancel(const OrderEvent&) {}
+    void onReduce(const OrderEvent&) {}
+    void onReject(SymbolID, OrderID, RejectReason) {}
+
+    void onDepth(SymbolID symbol, const DepthUpdate& update)
+    {
+        symbols.push_back(symbol);
+        updates.push_back(update);
+    }
+};
+
+template struct BasicMatchingEngine<DepthSink>;
+
+// A consumer's view of one book, rebuilt from the update stream alone.
+using LevelMap = std::map<std::pair<OrderSide, Price>, Quantity>;
+
+static void applyDepth(LevelMap& view, std::span<const DepthUpdate> updates)
+{
+    for (const DepthUpdate& update : updates)
+    {
+        if (update.qty == 0) view.erase({update.side, update.price});
+        else view[{update.side, update.price}] = update.qty;
+    }
+}
+
+// The book's best depth levels per side (all of them for depth 0), as a view.
+static LevelMap bookView(const OrderBook& book, std::size_t depth)
+{
+    LevelMap view;
+    auto add = [&](OrderSide side)
+    {
+        return [&, side, taken = std::size_t{}](Price price, const PriceLevel& level) mutable
+        {
+            view[{side, price}] = level.levelQTY;
+            return depth == 0 || ++taken < depth;
+        };
+    };
+    book.m_BidSide.forEachLevel(add(OrderSide::Bid));
+    book.m_AskSide.forEachLevel(add(OrderSide::Ask));
+    return view;
+}
+
+TEST(DepthFeedTest, EachCommandPublishesOneUpdatePerLevelItChanged)
+{
+    BasicMatchingEngine<DepthSink> engine(2);
+    engine.trackDepth(1);
+    engine.submitLimitOrder(0, OrderSide::Ask, 5, 1, 100);   // untracked book
+    EXPECT_TRUE(engine.sink.updates.empty());
+
+    engine.submitLimitOrder(1, OrderSide::Ask, 5, 2, 100);
+    engine.submitLimitOrder(1, OrderSide::Ask, 5, 3, 100);
+    engine.submitLimitOrder(1, OrderSide::Ask, 5, 4, 101);
+    ASSERT_EQ(engine.sink.updates.size(), 3u);
+    EXPECT_EQ(engine.sink.symbols[0], 1u);
+    EXPECT_EQ(engine.sink.updates[1].price, 100);
+    EXPECT_EQ(engine.sink.updates[1].qty, 10u);
+
+    // Three fills over two levels: one update per level, at the final totals.
+    engine.sink.updates.clear();
+    engine.submitMarketOrder(1, OrderSide::Bid, 12, 5);
+    ASSERT_EQ(engine.sink.updates.size(), 2u);
+    EXPECT_EQ(engine.sink.updates[0].side, OrderSide::Ask);
+    EXPECT_EQ(engine.sink.updates[0].price, 100);
+    EXPECT_EQ(engine.sink.updates[0].qty, 0u);
+    EXPECT_EQ(engine.sink.updates[1].price, 101);
+    EXPECT_EQ(engine.sink.updates[1].qty, 3u);
+
+    // A cancel-replace is one command touching both prices.
+    engine.sink.updates.clear();
+    engine.cancelReplace(4, 7, 103);
+    ASSERT_EQ(engine.sink.updates.size(), 2u);
+    EXPECT_EQ(engine.sink.updates[0].price, 101);
+    EXPECT_EQ(engine.sink.updates[0].qty, 0u);
+    EXPECT_EQ(engine.sink.updates[1].price, 103);
+    EXPECT_EQ(engine.sink.updates[1].qty, 7u);
+
+    engine.sink.updates.clear();
+    engine.reduceOrder(42, 1);                     // unknown: nothing changed
+    engine.submitLimitOrder(1, OrderSide::Bid, 0, 6, 90);   // rejected
+    EXPECT_TRUE(engine.sink.updates.empty());
+}
+
+TEST(DepthFeedTest, FullDepthStreamRebuildsTheBook)
+{
+    BasicMatchingEngine<DepthSink> engine(1, PriceBand{1, 200});
+    engine.trackDepth(kTicker);
+    LevelMap view;
+    std::vector<OrderID> ids;
+    std::mt19937 rng(22);
+    for (int i = 0; i < 5'000; ++i)
+    {
+        const auto side = rng() % 2 ? OrderSide::Bid : OrderSide::Ask;
+        const auto price = static_cast<Price>(rng() % 30 + 90);
+        const auto qty = static_cast<Quantity>(rng() % 10 + 1);
+        switch (rng() % 6)
+        {
+        case 0: engine.submitMarketOrder(kTicker, side, qty * 3, nextID()); break;
+        case 1: if (!ids.empty()) engine.cancelOrder(ids[rng() % ids.size()]); break;
+        case 2: if (!ids.empty()) engine.reduceOrder(ids[rng() % ids.size()], qty); break;
+        case 3: if (!ids.empty()) engine.cancelReplace(ids[rng() % ids.size()], qty, price); break;
+        default: engine.submitLimitOrder(kTicker, side, qty, ids.emplace_back(nextID()), price); break;
+        }
+        applyDepth(view, engine.sink.updates);
+        engine.sink.updates.clear();
+    }
+    EXPECT_EQ(view, bookView(engine.book[kTicker], 0));
+}
+
+TEST(DepthFeedTest, FixedCapacityTrackerGrowsOnTheHeapNotTheArena)
+{
+    EngineLimits limits;
+    limits.maxSymbols = 1;
+    limits.maxOrdersPerBook = 100'000;
+    limits.maxOrders = 100'000;
+    limits.band = PriceBand{1, 262'144};
+    limits.maxTrades = 1'024;
+    CountingResource heap; // outlives the engine, whose tracker frees into it
+    BasicMatchingEngine<DepthSink> engine(limits);
+    for (Price price = 1; price <= 100'000; ++price) engine.submitLimitOrder(kTicker, OrderSide::Ask, 1, nextID(), price * 2);
+    std::pmr::memory_resource* previous = std::pmr::set_default_resource(&heap);
+    engine.trackDepth(kTicker);
+    engine.sink.updates.reserve(100'001);
+    engine.sink.symbols.reserve(100'001);
+
+    // One command empties 100k levels. The arena never budgeted for the
+    // tracker, so the buffers that grow must come from the heap.
+    engine.submitMarketOrder(kTicker, OrderSide::Bid, 100'000, nextID());
+    std::pmr::set_default_resource(previous);
+    EXPECT_GT(heap.allocations, 0u);
+    EXPECT_EQ(engine.sink.updates.size(), 100'000u);
+    EXPECT_FALSE(engine.book[kTicker].hasAsks());
+    engine.submitLimitOrder(kTicker, OrderSide::Ask, 1, nextID(), 500);
+    EXPECT_EQ(engine.sink.updates.back().price, 500);
+}
+
+TEST(DepthFeedTest, TopNViewFollowsTheWindowAndIgnoresDeeperLevels)
+{
+    BasicMatchingEngine<DepthSink> engine(1);
+    constexpr OrderID kBase = 900'000;
+    for (Price price = 96; price <= 100; ++price) engine.submitLimitOrder(kTicker, OrderSide::Bid, 5, kBase + price, price);
+    engine.trackDepth(kTicker, 3);
+
+    // The first publication is the whole window.
+    engine.submitLimitOrder(kTicker, OrderSide::Bid, 1, kBase + 1, 97);   // below the window
+    LevelMap view;
+    applyDepth(view, engine.sink.updates);
+    EXPECT_EQ(view, bookView(engine.book[kTicker], 3));
+
+    engine.sink.updates.clear();
+    engine.submitLimitOrder(kTicker, OrderSide::Bid, 1, kBase + 2, 96);
+    engine.reduceOrder(kBase + 97, 2);
+    EXPECT_TRUE(engine.sink.updates.empty());
+
+    // Taking out the best level pulls 97 into the window.
+    engine.cancelOrder(kBase + 100);
+    ASSERT_EQ(engine.sink.updates.size(), 2u);
+    EXPECT_EQ(engine.sink.updates[0].price, 100);
+    EXPECT_EQ(engine.sink.updates[0].qty, 0u);
+    EXPECT_EQ(engine.sink.updates[1].price, 97);
+    EXPECT_EQ(engine.sink.updates[1].qty, 3u);
+
+    std::vector<OrderID> ids;
+    std::mt19937 rng(23);
+    for (int i = 0; i < 3'000; ++i)
+    {
+        applyDepth(view, engine.sink.updates);
+        engine.sink.updates.clear();
+        ASSERT_EQ(view, bookView(engine.book[kTicker], 3));
+        const auto side = rng() % 2 ? OrderSide::Bid : OrderSide::Ask;
+        const auto price = static_cast<Price>(rng() % 30 + 90);
+        switch (rng() % 4)
+        {
+        case 0: engine.submitMarketOrder(kTicker, side, static_cast<Quantity>(rng() % 20 + 1), nextID()); break;
+        case 1: if (!ids.empty()) engine.cancelOrder(ids[rng() % ids.size()]); break;
+        default: engine.submitLimitOrder(kTicker, side, static_cast<Quantity>(rng() % 10 + 1), ids.emplace_back(nextID()), price); break;
+        }
+    }
+    applyDepth(view, engine.sink.updates);
+    EXPECT_EQ(view, bookView(engine.book[kTicker], 3));
+}
+
+TEST(DepthFeedTest, ResetAndSnapshotLoadsPublishAtTheNextCollect)
+{
+    const std::string path = journalPath("depthfeed.snap");
+    auto tracked = []
+    {
+        BasicMatchingEngine<DepthSink> engine(2);
+        engine.configureBook(0, PriceBand{1, 200});
+        engine.trackDepth(0);
+        engine.trackDepth(1, 3);
+        return engine;
+    };
+    auto fill = [](BasicMatchingEngine<DepthSink>& engine, Price base)
+    {
+        for (SymbolID ticker = 0; ticker < 2; ++ticker)
+        {
+            for (Price price = base; price < base + 5; ++price)
+            {
+                engine.submitLimitOrder(ticker, OrderSide::Bid, 5, nextID(), price);
+                engine.submitLimitOrder(ticker, OrderSide::Ask, 5, nextID(), price + 20);
+            }
+        }
+    };
+    // Each consumer's view of both books, kept current from the sink and
+    // from direct collects outside a command.
+    LevelMap views[2];
+    auto drain = [&](BasicMatchingEngine<DepthSink>& engine)
+    {
+        for (std::size_t i = 0; i < engine.sink.updates.size(); ++i)
+        {
+            applyDepth(views[engine.sink.symbols[i]], std::span{&engine.sink.updates[i], 1});
+        }
+        engine.sink.updates.clear();
+        engine.sink.symbols.clear();
+        for (SymbolID ticker = 0; ticker < 2; ++ticker) applyDepth(views[ticker], engine.book[ticker].collectDepth());
+    };
+
+    BasicMatchingEngine<DepthSink> live = tracked();
+    fill(live, 90);
+    ASSERT_TRUE(live.saveSnapshot(path));
+
+    BasicMatchingEngine<DepthSink> engine = tracked();
+    fill(engine, 60);
+    drain(engine);
+    ASSERT_EQ(views[0].size(), 10u);
+    ASSERT_EQ(views[1].size(), 6u);
+
+    // A reset reports every published level as gone.
+    engine.reset();
+    drain(engine);
+    EXPECT_TRUE(views[0].empty());
+    EXPECT_TRUE(views[1].empty());
+
+    // A load publishes the restored levels and retracts the ones it replaced.
+    fill(engine, 60);
+    drain(engine);
+    ASSERT_TRUE(engine.loadSnapshot(path).has_value());
+    drain(engine);
+    EXPECT_EQ(views[0], bookView(engine.book[0], 0));
+    EXPECT_EQ(views[1], bookView(engine.book[1], 3));
+    EXPECT_EQ(views[0].begin()->first.second, 90);   // bids at 90.., none from 60..
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Depth Query Tests
+// ─────────────────────────────────────────────────────────────────────────────
+
+// Arrays for one symbol's depth, with a DepthBuffer over them.
+struct DepthArrays
+{
+    std::vector<Price> bidPrices, askPrices;
+    std::vector<Quantity> bidQuantities, askQuantities;
+
+    explicit DepthArrays(std::size_t levels)
+    : bidPrices(levels), askPrices(levels), bidQuantities(levels), askQuantities(levels)
+    {}
+
+    DepthBuffer buffer() { return DepthBuffer{bidPrices, bidQuantities, askPrices, askQuantities}; }
+};
+
+TEST(DepthQueryTest, ReturnsBestLevelsWithAggregatedQuantity)
+{
+    for (const bool ladder : {false, true})
+    {
+        MatchingEngine engine(1);
+        if (ladder) engine.configureBook(kTicker, PriceBand{1, 200});
+        for (Price price = 95; price <= 99; ++price)
+        {
+            engine.submitLimitOrder(kTicker, OrderSide::Bid, 1, nextID(), price);
+            engine.submitLimitOrder(kTicker, OrderSide::Bid, 2, nextID(), price);
+        }
+        engine.submitLimitOrder(kTicker, OrderSide::Ask, 7, nextID(), 101);
+
+        DepthArrays arrays(4);
+        DepthBuffer out = arrays.buffer();
+        engine.depth(kTicker, 3, out);
+        ASSERT_EQ(out.bids, 3u);
+        ASSERT_EQ(out.asks, 1u);
+        EXPECT_EQ(arrays.bidPrices[0], 99);
+        EXPECT_EQ(arrays.bidPrices[2], 97);
+        EXPECT_EQ(arrays.bidQuantities[1], 3u);
+        EXPECT_EQ(arrays.askPrices[0], 101);
+        EXPECT_EQ(arrays.askQuantities[0], 7u);
+
+        // The arrays bound the answer as well as the level count.
+        engine.depth(kTicker, 10, out);
+        EXPECT_EQ(out.bids, 4u);
+        EXPECT_EQ(arrays.bidPrices[3], 96);
+        engine.depth(kTicker, 0, out);
+        EXPECT_EQ(out.bids, 0u);
+        EXPECT_EQ(out.asks, 0u);
+    }
+}
+
+TEST(DepthQueryTest, BatchedQueryMatchesOneSymbolAtATime)
+{
+    constexpr std::size_t kSymbols = 8;
+    constexpr std::size_t kLevels = 5;
+    MatchingEngine engine(kSymbols, PriceBand{1, 200});
+    std::mt19937 rng(23);
+    for (int i = 0; i < 4'000; ++i)
+    {
+        const auto ticker = static_cast<SymbolID>(rng() % kSymbols);
+        const auto side = rng() % 2 ? OrderSide::Bid : OrderSide::Ask;
+        if (rng() % 5 == 0) engine.submitMarketOrder(ticker, side, static_cast<Quantity>(rng() % 20 + 1), nextID());
+        else engine.submitLimitOrder(ticker, side, static_cast<Quantity>(rng() % 10 + 1), nextID(), static_cast<Price>(rng() % 40 + 80));
+    }
+
+    // Every symbol's arrays end to end, queried in one call.
+    const std::vector<SymbolID> tickers{7, 0, 3, 3, 5};
+    std::vector<Price> prices(tickers.size() * 2 * kLevels);
+    std::vector<Quantity> quantities(prices.size());
+    std::vector<DepthBuffer> out;
+    for (std::size_t i = 0; i < tickers.size(); ++i)
+    {
+        const std::size_t bids = 2 * i * kLevels;
+        const std::size_t asks = bids + kLevels;
+        out.push_back(DepthBuffer{std::span(prices).subspan(bids, kLevels), std::span(quantities).subspan(bids, kLevels),
+                                  std::span(prices).subspan(asks, kLevels), std::span(quantities).subspan(asks, kLevels)});
+    }
+    engine.depth(tickers, kLevels, out);
+
+    for (std::size_t i = 0; i < tickers.size(); ++i)
+    {
+        DepthArrays single(kLevels);
+        DepthBuffer expected = single.buffer();
+        engine.depth(tickers[i], kLevels, expected);
+        ASSERT_EQ(out[i].bids, expected.bids);
+        ASSERT_EQ(out[i].asks, expected.asks);
+        for (std::size_t level = 0; level < expected.bids; ++level)
+        {
+            EXPECT_EQ(out[i].bidPrices[level], single.bidPrices[level]);
+            EXPECT_EQ(out[i].bidQuantities[level], single.bidQuantities[level]);
+        }
+        for (std::size_t level = 0; level < expected.asks; ++level)
+        {
+            EXPECT_EQ(out[i].askPrices[level], single.askPrices[level]);
+            EXPECT_EQ(out[i].askQuantities[level], single.askQuantities[level]);
+        }
+    }
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Top Of Book Tests
+// ─────────────────────────────────────────────────────────────────────────────
+
+static std::uint32_t walkCount(const OrderBook& book, const PriceLevel& level)
+{
+    std::uint32_t count{};
+    for (OrderHandle cursor = level.orders.head; cursor != kNullHandle; cursor = book.m_pool[cursor].next) ++count;
+    return count;
+}
+
+TEST(TopOfBookTest, CellFollowsBestLevelsAndLastTrade)
+{
+    MatchingEngine engine(2, PriceBand{1, 200});
+    engine.submitLimitOrder(1, OrderSide::Bid, 5, nextID(), 99);
+    engine.publishTopOfBook();
+    EXPECT_EQ(engine.topOfBook(1).read().bidPrice, 99);
+
+    engine.submitLimitOrder(1, OrderSide::Bid, 3, nextID(), 99);
+    engine.submitLimitOrder(1, OrderSide::Ask, 4, nextID(), 101);
+    engine.submitLimitOrder(1, OrderSide::Ask, 6, nextID(), 101);
+    TopOfBook top = engine.topOfBook(1).read();
+    EXPECT_EQ(top.bidQty, 8u);
+    EXPECT_EQ(top.bidOrders, 2u);
+    EXPECT_EQ(top.askPrice, 101);
+    EXPECT_EQ(top.askQty, 10u);
+    EXPECT_EQ(top.askOrders, 2u);
+    EXPECT_EQ(top.lastQty, 0u);
+
+    engine.submitMarketOrder(1, OrderSide::Bid, 5, nextID());
+    top = engine.topOfBook(1).read();
+    EXPECT_EQ(top.askQty, 5u);
+    EXPECT_EQ(top.askOrders, 1u);
+    EXPECT_EQ(top.lastPrice, 101);
+    EXPECT_EQ(top.lastQty, 1u);
+    EXPECT_EQ(top.lastTradeID, engine.id - 1);
+    EXPECT_EQ(engine.topOfBook(0).read(), TopOfBook{});
+
+    // Order counts stay exact through sweeps, cancels and replaces.
+    std::vector<OrderID> ids;
+    std::mt19937 rng(24);
+    for (int i = 0; i < 3'000; ++i)
+    {
+        const auto side = rng() % 2 ? OrderSide::Bid : OrderSide::Ask;
+        const auto price = static_cast<Price>(rng() % 20 + 90);
+        switch (rng() % 5)
+        {
+        case 0: engine.submitMarketOrder(1, side, static_cast<Quantity>(rng() % 60 + 1), nextID()); break;
+        case 1: if (!ids.empty()) engine.cancelOrder(ids[rng() % ids.size()]); break;
+        case 2: if (!ids.empty()) engine.cancelReplace(ids[rng() % ids.size()], 2, price); break;
+        default: engine.submitLimitOrder(1, side, 1, ids.emplace_back(nextID()), price); break;
+        }
+        top = engine.topOfBook(1).read();
+        OrderBook& book = engine.book[1];
+        ASSERT_EQ(top.bidOrders, book.hasBids() ? walkCount(book, book.m_BidSide.bestLevel()) : 0u);
+        ASSERT_EQ(top.askOrders, book.hasAsks() ? walkCount(book, book.m_AskSide.bestLevel()) : 0u);
+        ASSERT_EQ(top.bidPrice, book.bestBid().value_or(0));
+    }
+
+    engine.reset();
+    EXPECT_EQ(engine.topOfBook(1).read(), TopOfBook{});
+}
+
+TEST(TopOfBookTest, OnlyChangesAtTheTopRepublish)
+{
+    MatchingEngine engine(1);
+    engine.submitLimitOrder(kTicker, OrderSide::Bid, 5, nextID(), 99);
+    EXPECT_EQ(engine.topOfBook(kTicker).version(), 0u);   // off by default
+
+    engine.publishTopOfBook();
+    const std::uint64_t enabled = engine.topOfBook(kTicker).version();
+    EXPECT_EQ(enabled, 1u);
+    engine.submitLimitOrder(kTicker, OrderSide::Bid, 5, nextID(), 90);   // below the best
+    engine.cancelOrder(424242);                                       // unknown
+    EXPECT_EQ(engine.topOfBook(kTicker).version(), enabled);
+    engine.submitLimitOrder(kTicker, OrderSide::Bid, 5, nextID(), 99);
+    EXPECT_EQ(engine.topOfBook(kTicker).version(), enabled + 1);
+
+    engine.publishTopOfBook(false);
+    engine.submitLimitOrder(kTicker, OrderSide::Bid, 5, nextID(), 100);
+    EXPECT_EQ(engine.topOfBook(kTicker).read().bidPrice, 99);
+}
+
+TEST(TopOfBookTest, ConcurrentReadersNeverSeeATornRecord)
+{
+    // Every field of record k is derived from k, so a mix of two records
+    // shows up as fields that disagree.
+    auto record = [](std::uint32_t k)
+    {
+        return TopOfBook{static_cast<Price>(k), k, k + 1, static_cast<Price>(k + 2), k + 3, k + 4,
+                         static_cast<Price>(k + 5), k + 6, std::uint64_t{k} * 7};
+    };
+    TopOfBookCell cell;
+    cell.publish(record(0));
+    std::atomic<bool> done{false};
+    std::atomic<std::uint64_t> torn{0};
+    std::atomic<std::uint64_t> reads{0};
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 3; ++r)
+    {
+        readers.emplace_back([&]
+        {
+            std::uint32_t last{};
+            while (!done.load(std::memory_order_acquire))
+            {
+                TopOfBook top;
+                if (!cell.tryRead(top)) continue;
+                const auto k = static_cast<std::uint32_t>(top.bidPrice);
+                if (top != record(k) || k < last) torn.fetch_add(1);
+                last = k;
+                reads.fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+    }
+    for (std::uint32_t k = 1; k <= 200'000; ++k) cell.publish(record(k));
+    done.store(true, std::memory_order_release);
+    for (std::thread& reader : readers) reader.join();
+    EXPECT_EQ(torn.load(), 0u);
+    EXPECT_GT(reads.load(), 0u);
+    EXPECT_EQ(cell.read(), record(200'000));
+    EXPECT_EQ(cell.version(), 200'001u);
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+// Depth View Tests
+// ─────────────────────────────────────────────────────────────────────────────
+
+static LevelMap imageView(const DepthView& image)
+{
+    LevelMap view;
+    for (std::size_t i = 0; i < image.bidPrices().size(); ++i) view[{OrderSide::Bid, image.bidPrices()[i]}] = image.bidQuantities()[i];
+    for (std::size_t i = 0; i < image.askPrices().size(); ++i) view[{OrderSide::Ask, image.askPrices()[i]}] = image.askQuantities()[i];
+    return view;
+}
+
+TEST(DepthViewTest, RefreshesAtTheCommandCadence)
+{
+    MatchingEngine engine(2);
+    EXPECT_EQ(engine.depthView(kTicker), nullptr);
+    engine.submitLimitOrder(kTicker, OrderSide::Bid, 5, nextID(), 99);
+    engine.publishDepthView(kTicker, DepthViewCadence{3, {}});
+    const PublishedDepth& published = *engine.depthView(kTicker);
+    EXPECT_EQ(published.epoch(), 1u);
+    EXPECT_EQ(imageView(published.acquire()), bookView(engine.book[kTicker], 0));
+
+    engine.submitLimitOrder(kTicker, OrderSide::Ask, 4, nextID(), 6'001);
+    engine.submitLimitOrder(1, OrderSide::Ask, 4, nextID(), 6'001);     // other books do not count
+    engine.submitLimitOrder(kTicker, OrderSide::Ask, 6, nextID(), 6'002);
+    EXPECT_EQ(published.acquire().askPrices().size(), 0u);
+    engine.submitLimitOrder(kTicker, OrderSide::Bid, 2, nextID(), 98);
+    {
+        const DepthView image = published.acquire();
+        EXPECT_EQ(image.epoch(), 2u);
+        EXPECT_EQ(image.bidPrices()[0], 99);
+        EXPECT_EQ(image.askPrices()[1], 6'002);
+        EXPECT_EQ(imageView(image), bookView(engine.book[kTicker], 0));
+    }
+
+    // Thousands of levels come and go, nothing crosses, and every third
+    // command the image is the book.
+    std::vector<OrderID> ids;
+    std::mt19937 rng(25);
+    for (int i = 1; i <= 6'000; ++i)
+    {
+        const auto side = rng() % 2 ? OrderSide::Bid : OrderSide::Ask;
+        const auto price = static_cast<Price>(side == OrderSide::Bid ? rng() % 3'000 + 1 : rng() % 3'000 + 3'001);
+        if (rng() % 3 == 0 && !ids.empty())
+        {
+            std::swap(ids[rng() % ids.size()], ids.back());
+            engine.cancelOrder(ids.back());
+            ids.pop_back();
+        }
+        else engine.submitLimitOrder(kTicker, side, static_cast<Quantity>(rng() % 9 + 1), ids.emplace_back(nextID()), price);
+        if (i % 3 == 0)
+        {
+            ASSERT_EQ(imageView(published.acquire()), bookView(engine.book[kTicker], 0));
+        }
+    }
+    EXPECT_EQ(published.epoch(), 2u + 2'000u);
+    EXPECT_EQ(published.skipped(), 0u);
+}
+
+TEST(DepthViewTest, HeldImageDefersTheRefreshInsteadOfWaiting)
+{
+    MatchingEngine engine(1, PriceBand{1, 200});
+    engine.submitLimitOrder(kTicker, OrderSide::Bid, 5, nextID(), 99);
+    engine.publishDepthView(kTicker, DepthViewCadence{1, {}});
+    const PublishedDepth& published = *engine.depthView(kTicker);
+
+    DepthView held = published.acquire();
+    const LevelMap before = imageView(held);
+    engine.submitLimitOrder(kTicker, OrderSide::Bid, 5, nextID(), 98);   // fills the other buffer
+    EXPECT_EQ(published.epoch(), 2u);
+    engine.submitLimitOrder(kTicker, OrderSide::Bid, 5, nextID(), 97);   // would overwrite held
+    engine.submitLimitOrder(kTicker, OrderSide::Ask, 5, nextID(), 120);
+    EXPECT_EQ(published.epoch(), 2u);
+    EXPECT_EQ(published.skipped(), 2u);
+    EXPECT_EQ(held.epoch(), 1u);
+    EXPECT_EQ(imageView(held), before);
+
+    // Moving the hold keeps it; letting go lets the next command publish.
+    DepthView moved = std::move(held);
+    engine.submitLimitOrder(kTicker, OrderSide::Ask, 5, nextID(), 121);
+    EXPECT_EQ(published.skipped(), 3u);
+    moved = DepthView{};
+    engine.submitLimitOrder(kTicker, OrderSide::Ask, 5, nextID(), 122);
+    const DepthView image = published.acquire();
+    EXPECT_EQ(image.epoch(), 3u);
+    EXPECT_EQ(imageView(image), bookView(engine.book[kTicker], 0));
+}
+
+TEST(DepthViewTest, ResetAndSnapshotLoadsRepublishAtOnce)
+{
+    const std::string path = journalPath("depthview.snap");
+    MatchingEngine live = snapshotEngine();
+    std::vector<OrderID> ids;
+    std::mt19937 rng(25);
+    churn(live, ids, rng, 2'000);
+    ASSERT_TRUE(live.saveSnapshot(path));
+
+    // The cadence never comes round, so only reset() and the load publish.
+    MatchingEngine restored = snapshotEngine();
+    restored.publishDepthView(0, DepthViewCadence{1'000, {}});
+    const PublishedDepth& published = *restored.depthView(0);
+    restored.submitLimitOrder(0, OrderSide::Bid, 5, nextID(), 50);
+    restored.reset();
+    EXPECT_EQ(published.epoch(), 2u);
+    EXPECT_TRUE(imageView(published.acquire()).empty());
+    ASSERT_TRUE(restored.loadSnapshot(path).has_value());
+    EXPECT_GT(published.epoch(), 2u);
+    EXPECT_EQ(imageView(published.acquire()), bookView(live.book[0], 0));
+
+    // With a reader pinning the idle buffer the publishes of a load are put
+    // off, and the next command retries rather than waiting for the cadence.
+    DepthView held = published.acquire();
+    restored.reset();
+    const std::uint64_t emptied = published.epoch();
+    ASSERT_TRUE(restored.loadSnapshot(path).has_value());
+    EXPECT_EQ(published.epoch(), emptied);
+    EXPECT_GT(published.skipped(), 0u);
+    held = DepthView{};
+    restored.submitLimitOrder(0, OrderSide::Bid, 5, nextID(), 1);
+    const DepthView image = published.acquire();
+    EXPECT_EQ(image.epoch(), emptied + 1);
+    EXPECT_EQ(imageView(image), bookView(restored.book[0], 0));
+}
+
+TEST(DepthViewTest, ConcurrentReadersSeeWholeImagesOnATimer)
+{
+    MatchingEngine engine(1, PriceBand{1, 2'000});
+    engine.publishDepthView(kTicker, DepthViewCadence{0, std::chrono::microseconds{20}});
+    const PublishedDepth& published = *engine.depthView(kTicker);
+    std::atomic<bool> done{false};
+    std::atomic<std::uint64_t> broken{0};
+    std::atomic<std::uint64_t> reads{0};
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 3; ++r)
+    {
+        readers.emplace_back([&]
+        {
+            std::uint64_t last{};
+            while (!done.load(std::memory_order_acquire))
+            {
+                // Between commands the book is sorted, has no empty level
+                // and is never crossed; a half-written image would not be.
+                const DepthView image = published.acquire();
+                const auto bids = image.bidPrices();
+                const auto asks = image.askPrices();
+                bool whole = image.epoch() >= last;
+                for (std::size_t i = 0; i < bids.size(); ++i) whole &= image.bidQuantities()[i] > 0 && (i == 0 || bids[i] < bids[i - 1]);
+                for (std::size_t i = 0; i < asks.size(); ++i) whole &= image.askQuantities()[i] > 0 && (i == 0 || asks[i] > asks[i - 1]);
+                if (!bids.empty() && !asks.empty()) whole &= bids[0] < asks[0];
+                if (!whole) broken.fetch_add(1);
+                last = image.epoch();
+                reads.fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+    }
+    std::mt19937 rng(2'025);
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 300'000 || std::chrono::steady_clock::now() - start < std::chrono::milliseconds(50); ++i)
+    {
+        const auto side = rng() % 2 ? OrderSide::Bid : OrderSide::Ask;
+        const auto price = static_cast<Price>(rng() % 400 + 800);
+        if (rng() % 4 == 0) engine.submitMarketOrder(kTicker, side, static_cast<Quantity>(rng() % 20 + 1), nextID());
+        else engine.submitLimitOrder(kTicker, side, static_cast<Quantity>(rng() % 9 + 1), nextID(), price);
+    }
+    done.store(true, std::memory_order_release);
+    for (std::thread& reader : readers) reader.join();
+    EXPECT_EQ(broken.load(), 0u);
+    EXPECT_GT(reads.load(), 0u);
+    EXPECT_GT(published.epoch(), 1u);
+}